@@ -0,0 +1,546 @@
+/********************************************************************************
+*                                                                               *
+*                 C a c h e s   F o r   Cairo device context                    *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2013 by Stephen J. Hardy.   All Rights Reserved.                *
+*********************************************************************************
+* This library is free software; you can redistribute it and/or                 *
+* modify it under the terms of the GNU Lesser General Public                    *
+* License as published by the Free Software Foundation; either                  *
+* version 2.1 of the License, or (at your option) any later version.            *
+*                                                                               *
+* This library is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU             *
+* Lesser General Public License for more details.                               *
+*                                                                               *
+* You should have received a copy of the GNU Lesser General Public              *
+* License along with this library; if not, write to the Free Software           *
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.    *
+*********************************************************************************
+* $Id: $                     *
+********************************************************************************/
+
+#include "xincs.h"
+#include "fxver.h"
+#include "fxdefs.h"
+#include "FXHash.h"
+#include "FXStream.h"
+#include "FXString.h"
+#include "FXPoint.h"
+#include "FXRectangle.h"
+#include "FXId.h"
+#include "FXFont.h"
+#include "FXDC.h"
+#include "FXDCWindow.h"
+
+#include "xincs_cairo.h"
+
+#include "config.h"
+#include "FXDCCairo.h"
+#include "FXCairoCache.h"
+
+
+/*
+  Notes:
+  - The hash table is a fixed number of buckets (a power of 2), chosen by the
+    subclass for the number of entries it expects.
+  - Nothing here is thread safe; caches are only used from the GUI thread.
+*/
+
+using namespace FX;
+
+namespace FX
+{
+
+
+// Construct empty cache
+FXCairoCache::FXCairoCache(FXuint nb, FXuval bud, FXuint maxent):
+	nbuckets(nb),
+	mru(NULL),
+	lru(NULL),
+	budget(bud),
+	maxentries(maxent)
+{
+	FXCALLOC(&buckets, Entry *, nbuckets);
+	memset(&stats, 0, sizeof(stats));
+}
+
+
+// Unlink from hash chain and LRU list
+void FXCairoCache::unlink(Entry * e)
+{
+	Entry ** pp = &buckets[e->hash & (nbuckets-1)];
+	while (*pp != e)
+		pp = &(*pp)->hnext;
+	*pp = e->hnext;
+	if (e->lprev)
+		e->lprev->lnext = e->lnext;
+	else
+		mru = e->lnext;
+	if (e->lnext)
+		e->lnext->lprev = e->lprev;
+	else
+		lru = e->lprev;
+	--stats.entries;
+	stats.bytes -= e->bytes;
+}
+
+
+// Find entry matching key, and make it most recently used
+FXCairoCache::Entry * FXCairoCache::find(FXuint hash, const void * key)
+{
+	for (Entry * e = buckets[hash & (nbuckets-1)]; e; e = e->hnext) {
+		if (e->hash != hash || !match(e, key))
+			continue;
+		if (stale(e, key)) {
+			remove(e);
+			++stats.evictions;
+			break;
+		}
+		if (e != mru) {
+			e->lprev->lnext = e->lnext;
+			if (e->lnext)
+				e->lnext->lprev = e->lprev;
+			else
+				lru = e->lprev;
+			e->lprev = NULL;
+			e->lnext = mru;
+			mru->lprev = e;
+			mru = e;
+		}
+		++stats.hits;
+		return e;
+	}
+	++stats.misses;
+	return NULL;
+}
+
+
+// Add entry as most recently used
+void FXCairoCache::insert(Entry * e, FXuint hash, FXuval bytes)
+{
+	Entry ** b = &buckets[hash & (nbuckets-1)];
+	e->hash = hash;
+	e->bytes = bytes;
+	e->hnext = *b;
+	*b = e;
+	e->lprev = NULL;
+	e->lnext = mru;
+	if (mru)
+		mru->lprev = e;
+	else
+		lru = e;
+	mru = e;
+	++stats.entries;
+	stats.bytes += bytes;
+	trim();
+}
+
+
+// Remove and destroy entry
+void FXCairoCache::remove(Entry * e)
+{
+	unlink(e);
+	destroy(e);
+}
+
+
+// Evict least recently used entries until within budget.  The most recently
+// used entry is always kept, even if it alone exceeds the budget.
+void FXCairoCache::trim()
+{
+	while (lru && lru != mru && (stats.bytes > budget || stats.entries > maxentries)) {
+		remove(lru);
+		++stats.evictions;
+	}
+}
+
+
+// Remove everything
+void FXCairoCache::clear()
+{
+	while (lru)
+		remove(lru);
+}
+
+
+// Subclasses have already cleared
+FXCairoCache::~FXCairoCache()
+{
+	FXFREE(&buckets);
+}
+
+
+/*******************************************************************************/
+
+
+// Construct image cache
+FXCairoImageCache::FXCairoImageCache(FXuval bud, FXuint maxent):
+	FXCairoCache(256, bud, maxent)
+{
+}
+
+
+FXuint FXCairoImageCache::hashKey(const Key & key)
+{
+	FXuint h = fxCairoHashPtr(key.obj);
+	h = fxCairoHashMix(h, key.kind);
+	h = fxCairoHashMix(h, key.c1);
+	h = fxCairoHashMix(h, key.c2);
+	return h;
+}
+
+
+// Same object, conversion and colours
+FXbool FXCairoImageCache::match(const Entry * e, const void * key) const
+{
+	const Key & a = ((const ImageEntry *)e)->key;
+	const Key & b = *(const Key *)key;
+	return a.obj == b.obj && a.kind == b.kind && a.c1 == b.c1 && a.c2 == b.c2;
+}
+
+
+// Object has changed since conversion
+FXbool FXCairoImageCache::stale(const Entry * e, const void * key) const
+{
+	const Key & a = ((const ImageEntry *)e)->key;
+	const Key & b = *(const Key *)key;
+	return a.data != b.data || a.w != b.w || a.h != b.h || a.xid != b.xid;
+}
+
+
+void FXCairoImageCache::destroy(Entry * e)
+{
+	cairo_surface_destroy(((ImageEntry *)e)->surf);
+	delete (ImageEntry *)e;
+}
+
+
+// Look up converted surface
+cairo_surface_t * FXCairoImageCache::lookup(const Key & key)
+{
+	ImageEntry * e = (ImageEntry *)find(hashKey(key), &key);
+	return e ? cairo_surface_reference(e->surf) : NULL;
+}
+
+
+// Store converted surface
+void FXCairoImageCache::store(const Key & key, cairo_surface_t * s)
+{
+	ImageEntry * e = new ImageEntry;
+	e->key = key;
+	e->surf = cairo_surface_reference(s);
+	if (key.kind == IMAGE_WRAPPED)
+		insert(e, hashKey(key), sizeof(ImageEntry));
+	else
+		insert(e, hashKey(key), (FXuval)cairo_image_surface_get_stride(s)*cairo_image_surface_get_height(s));
+}
+
+
+// Drop everything converted from obj
+void FXCairoImageCache::invalidate(const void * obj)
+{
+	Entry * n;
+	for (Entry * e = mru; e; e = n) {
+		n = e->lnext;
+		if (((ImageEntry *)e)->key.obj == obj)
+			remove(e);
+	}
+}
+
+
+FXCairoImageCache::~FXCairoImageCache()
+{
+	clear();
+}
+
+/*******************************************************************************/
+
+
+// Construct layout cache
+FXCairoLayoutCache::FXCairoLayoutCache(FXuval bud, FXuint maxent):
+	FXCairoCache(512, bud, maxent),
+	context(NULL)
+{
+}
+
+
+FXuint FXCairoLayoutCache::hashKey(const Key & key)
+{
+	FXuint h = pango_font_description_hash(key.pfd);
+	for (FXuint i = 0; i < key.length; ++i)
+		h = fxCairoHashMix(h, (FXuchar)key.text[i]);
+	return fxCairoHashMix(h, key.length);
+}
+
+
+// Same text in equal font
+FXbool FXCairoLayoutCache::match(const Entry * e, const void * key) const
+{
+	const LayoutEntry * a = (const LayoutEntry *)e;
+	const Key & b = *(const Key *)key;
+	return a->length == b.length && !memcmp(a->text, b.text, b.length) &&
+	       pango_font_description_equal(a->pfd, b.pfd);
+}
+
+
+void FXCairoLayoutCache::destroy(Entry * e)
+{
+	LayoutEntry * le = (LayoutEntry *)e;
+	g_object_unref(le->layout);
+	pango_font_description_free(le->pfd);
+	FXFREE(&le->text);
+	delete le;
+}
+
+
+// Look up layout, or shape a new one
+PangoLayout * FXCairoLayoutCache::lookup(const Key & key)
+{
+	FXuint hash = hashKey(key);
+	LayoutEntry * e = (LayoutEntry *)find(hash, &key);
+	if (e)
+		return e->layout;
+	if (!context)
+		context = pango_font_map_create_context(pango_cairo_font_map_get_default());
+	e = new LayoutEntry;
+	e->pfd = pango_font_description_copy(key.pfd);
+	FXMALLOC(&e->text, FXchar, key.length+1);
+	memcpy(e->text, key.text, key.length);
+	e->text[key.length] = 0;
+	e->length = key.length;
+	e->layout = pango_layout_new(context);
+	pango_layout_set_font_description(e->layout, e->pfd);
+	pango_layout_set_text(e->layout, e->text, e->length);
+	// Rough allowance for the lines, runs and glyphs which Pango keeps
+	insert(e, hash, sizeof(LayoutEntry) + 256 + e->length*48);
+	return e->layout;
+}
+
+
+FXCairoLayoutCache::~FXCairoLayoutCache()
+{
+	clear();
+	if (context)
+		g_object_unref(context);
+}
+
+/*******************************************************************************/
+
+
+// Construct font cache; there is no size budget, only a number of entries
+FXCairoFontCache::FXCairoFontCache(FXuint maxent):
+	FXCairoCache(64, ~(FXuval)0, maxent),
+	context(NULL)
+{
+}
+
+
+FXuint FXCairoFontCache::hashKey(const Key & key)
+{
+	return fxCairoHashPtr(key.font);
+}
+
+
+// Same font object
+FXbool FXCairoFontCache::match(const Entry * e, const void * key) const
+{
+	return ((const FontEntry *)e)->key.font == ((const Key *)key)->font;
+}
+
+
+// Font changed since the description was made
+FXbool FXCairoFontCache::stale(const Entry * e, const void * key) const
+{
+	const Key & a = ((const FontEntry *)e)->key;
+	const Key & b = *(const Key *)key;
+	return a.size != b.size || a.weight != b.weight || a.slant != b.slant ||
+	       a.setwidth != b.setwidth || strcmp(a.family, b.family) != 0;
+}
+
+
+void FXCairoFontCache::destroy(Entry * e)
+{
+	FontEntry * fe = (FontEntry *)e;
+	if (fe->metrics) pango_font_metrics_unref(fe->metrics);
+	if (fe->pango) g_object_unref(fe->pango);
+	pango_font_description_free(fe->pfd);
+	FXFREE(&fe->key.family);
+	delete fe;
+}
+
+
+// New description of font
+PangoFontDescription * FXCairoFontCache::describe(const Key & key)
+{
+	PangoFontDescription * pfd = pango_font_description_new();
+	pango_font_description_set_family(pfd, key.family);
+	pango_font_description_set_style(pfd,
+		key.slant == FXFont::Italic ? PANGO_STYLE_ITALIC :
+		key.slant == FXFont::Oblique ? PANGO_STYLE_OBLIQUE :
+		PANGO_STYLE_NORMAL);
+	pango_font_description_set_weight(pfd, (PangoWeight)(key.weight * 10));
+	pango_font_description_set_stretch(pfd,
+		key.setwidth == FXFont::UltraCondensed ? PANGO_STRETCH_ULTRA_CONDENSED :
+		key.setwidth == FXFont::ExtraCondensed ? PANGO_STRETCH_EXTRA_CONDENSED :
+		key.setwidth == FXFont::Condensed ? PANGO_STRETCH_CONDENSED :
+		key.setwidth == FXFont::SemiCondensed ? PANGO_STRETCH_SEMI_CONDENSED :
+		key.setwidth == FXFont::SemiExpanded ? PANGO_STRETCH_SEMI_EXPANDED :
+		key.setwidth == FXFont::Expanded ? PANGO_STRETCH_EXPANDED :
+		key.setwidth == FXFont::ExtraExpanded ? PANGO_STRETCH_EXTRA_EXPANDED :
+		key.setwidth == FXFont::UltraExpanded ? PANGO_STRETCH_ULTRA_EXPANDED :
+		PANGO_STRETCH_NORMAL);
+	pango_font_description_set_size(pfd, key.size*PANGO_SCALE/10);
+	return pfd;
+}
+
+
+// Find entry, or describe the font in a new one
+FXCairoFontCache::FontEntry * FXCairoFontCache::entry(const Key & key)
+{
+	FXuint hash = hashKey(key);
+	FontEntry * e = (FontEntry *)find(hash, &key);
+	if (e)
+		return e;
+	e = new FontEntry;
+	e->key = key;
+	FXuint n = strlen(key.family);
+	FXMALLOC(&e->key.family, FXchar, n+1);
+	memcpy((FXchar *)e->key.family, key.family, n+1);
+	e->pfd = describe(key);
+	e->pango = NULL;
+	e->metrics = NULL;
+	insert(e, hash, sizeof(FontEntry) + n+1);
+	return e;
+}
+
+
+// Look up description
+PangoFontDescription * FXCairoFontCache::lookup(const Key & key)
+{
+	return entry(key)->pfd;
+}
+
+
+// Look up metrics, resolving the font the first time
+PangoFontMetrics * FXCairoFontCache::getMetrics(const Key & key)
+{
+	FontEntry * e = entry(key);
+	if (!e->metrics) {
+		if (!context)
+			context = pango_font_map_create_context(pango_cairo_font_map_get_default());
+		if (!e->pango)
+			e->pango = pango_context_load_font(context, e->pfd);
+		if (e->pango)
+			e->metrics = pango_font_get_metrics(e->pango, NULL);
+	}
+	return e->metrics;
+}
+
+
+// Remove entry for font
+void FXCairoFontCache::invalidate(const void * font)
+{
+	FXuint hash = fxCairoHashPtr(font);
+	for (Entry * e = buckets[hash & (nbuckets-1)]; e; e = e->hnext) {
+		if (e->hash == hash && ((FontEntry *)e)->key.font == font) {
+			remove(e);
+			return;
+		}
+	}
+}
+
+
+FXCairoFontCache::~FXCairoFontCache()
+{
+	clear();
+	if (context)
+		g_object_unref(context);
+}
+
+/*******************************************************************************/
+
+
+// Construct path cache
+FXCairoPathCache::FXCairoPathCache(FXuval bud, FXuint maxent):
+	FXCairoCache(64, bud, maxent)
+{
+}
+
+
+FXuint FXCairoPathCache::hashKey(const Key & key)
+{
+	FXuint h = fxCairoHashPtr(key.obj);
+	const FXuchar * p = (const FXuchar *)key.data;
+	for (FXuint i = 0; i < key.size; ++i)
+		h = fxCairoHashMix(h, p[i]);
+	return fxCairoHashMix(h, key.size);
+}
+
+
+// Same owner, same data and same shape
+FXbool FXCairoPathCache::match(const Entry * e, const void * key) const
+{
+	const PathEntry * a = (const PathEntry *)e;
+	const Key & b = *(const Key *)key;
+	if (a->obj != b.obj || a->size != b.size || memcmp(a->data, b.data, b.size))
+		return FALSE;
+	if (!a->shape || !b.shape)
+		return !a->shape && !b.shape;
+	return sameShape(a->shape, b.shape);
+}
+
+
+void FXCairoPathCache::destroy(Entry * e)
+{
+	PathEntry * pe = (PathEntry *)e;
+	cairo_path_destroy(pe->path);
+	if (pe->shape)
+		freeShape(pe->shape);
+	FXFREE(&pe->data);
+	delete pe;
+}
+
+
+// Look up converted path
+cairo_path_t * FXCairoPathCache::lookup(const Key & key)
+{
+	PathEntry * e = (PathEntry *)find(hashKey(key), &key);
+	return e ? e->path : NULL;
+}
+
+
+// Store converted path
+void FXCairoPathCache::store(const Key & key, cairo_path_t * path)
+{
+	PathEntry * e = new PathEntry;
+	e->obj = key.obj;
+	FXMALLOC(&e->data, FXuchar, key.size+1);
+	memcpy(e->data, key.data, key.size);
+	e->size = key.size;
+	e->shape = key.shape ? copyShape(key.shape) : NULL;
+	e->path = path;
+	insert(e, hashKey(key), sizeof(PathEntry) + key.size + path->num_data*sizeof(cairo_path_data_t));
+}
+
+
+// Drop everything converted from obj
+void FXCairoPathCache::invalidate(const void * obj)
+{
+	Entry * n;
+	for (Entry * e = mru; e; e = n) {
+		n = e->lnext;
+		if (((PathEntry *)e)->obj == obj)
+			remove(e);
+	}
+}
+
+
+FXCairoPathCache::~FXCairoPathCache()
+{
+	clear();
+}
+
+}
@@ -0,0 +1,355 @@
+/********************************************************************************
+*                                                                               *
+*                 C a c h e s   F o r   Cairo device context                    *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2013 by Stephen J. Hardy.   All Rights Reserved.                *
+*********************************************************************************
+* This library is free software; you can redistribute it and/or                 *
+* modify it under the terms of the GNU Lesser General Public                    *
+* License as published by the Free Software Foundation; either                  *
+* version 2.1 of the License, or (at your option) any later version.            *
+*                                                                               *
+* This library is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU             *
+* Lesser General Public License for more details.                               *
+*                                                                               *
+* You should have received a copy of the GNU Lesser General Public              *
+* License along with this library; if not, write to the Free Software           *
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.    *
+*********************************************************************************
+* $Id: $                        *
+********************************************************************************/
+#ifndef FXCAIROCACHE_H
+#define FXCAIROCACHE_H
+
+/*
+	Private to the library.  Include after xincs_cairo.h and FXDCCairo.h.
+*/
+
+namespace FX
+{
+
+
+/**
+* Base class for the LRU caches used by FXDCCairo.
+*
+* Entries are allocated by the subclass, which derives its entry type from
+* FXCairoCache::Entry and supplies the key comparison and the destruction of
+* an entry.  The cache keeps entries in a hash table and in a list ordered by
+* last use, and evicts from the least recently used end whenever the total
+* size or the number of entries exceeds the budget.
+*
+* Keys are compared in two steps: match() decides if an entry is for the same
+* object, and stale() if that object has changed since the entry was made.
+* A stale entry is removed, and the lookup counts as a miss.
+*/
+class FXCairoCache
+{
+public:
+	struct Entry {
+		Entry * lprev;		// More recently used
+		Entry * lnext;		// Less recently used
+		Entry * hnext;		// Next in hash bucket
+		FXuint hash;
+		FXuval bytes;		// Memory held by the entry
+	};
+
+protected:
+	Entry ** buckets;
+	FXuint nbuckets;
+	Entry * mru;
+	Entry * lru;
+	FXuval budget;
+	FXuint maxentries;
+	FXCairoCacheStats stats;
+
+	virtual FXbool match(const Entry * e, const void * key) const = 0;
+	virtual FXbool stale(const Entry * e, const void * key) const { return FALSE; }
+	virtual void destroy(Entry * e) = 0;
+	void unlink(Entry * e);
+
+private:
+	FXCairoCache(const FXCairoCache&);
+	FXCairoCache &operator=(const FXCairoCache&);
+
+public:
+	FXCairoCache(FXuint nb, FXuval bud, FXuint maxent);
+
+	/// Find entry; returns NULL if not found (or found stale)
+	Entry * find(FXuint hash, const void * key);
+
+	/// Add a new entry, then evict old ones to stay within budget
+	void insert(Entry * e, FXuint hash, FXuval bytes);
+
+	/// Remove and destroy an entry
+	void remove(Entry * e);
+
+	/// Evict entries until within budget
+	void trim();
+
+	/// Remove all entries
+	void clear();
+
+	/// Most recently used entry; follow lnext for the rest
+	Entry * first() const { return mru; }
+
+	void setBudget(FXuval bytes) { budget = bytes; trim(); }
+	FXuval getBudget() const { return budget; }
+	void setMaxEntries(FXuint n) { maxentries = n; trim(); }
+	FXuint getMaxEntries() const { return maxentries; }
+
+	const FXCairoCacheStats & getStats() const { return stats; }
+	void resetStats() { stats.hits = stats.misses = stats.evictions = 0; }
+
+	/// Subclass destructors must call clear()
+	virtual ~FXCairoCache();
+};
+
+
+/// Hash helpers
+static inline FXuint fxCairoHashPtr(const void * p)
+{
+	FXuval v = (FXuval)p;
+	return (FXuint)(v ^ (v>>13) ^ (v>>29));
+}
+
+static inline FXuint fxCairoHashMix(FXuint h, FXuint v)
+{
+	return (h ^ v) * 16777619U;
+}
+
+
+/**
+* Cache of client-side Cairo image surfaces converted from FOX images,
+* bitmaps and icons.
+*
+* The key is the FOX object, the kind of conversion and up to two colours
+* which it depends on.  Each entry also records a stamp: the client data
+* pointer, size and X id of the object when converted.  If the stamp no longer
+* matches the object, the entry is stale.  The X id serves as the generation:
+* an object deleted and another made at the same address, even with its buffer
+* at the same address, has a new id once created.  The stamp does not change
+* when pixels are modified in place; then FXDCCairo::invalidateImage() must be
+* called.
+*/
+class FXCairoImageCache : public FXCairoCache
+{
+public:
+	enum {
+		BITMAP_A1,			// FXBitmap as A1 mask
+		BITMAP_ARGB32,		// FXBitmap with c1/c2 for 1/0 pixels
+		IMAGE_ARGB32,		// FXImage pixels
+		IMAGE_KEYED,		// FXImage pixels, c1 made transparent
+		IMAGE_MASK,			// FXImage mask, c1 is the transparent colour
+		STIPPLE_ARGB32,		// Stipple repeat pattern, c1/c2 for 1/0 pixels
+		ICON_NORMAL,		// FXIcon drawn with its mask, c1 is the transparent colour
+		ICON_SHADED,		// As above, shaded with c2 (selback colour)
+		ICON_SUNKEN,		// As above, sunken with c2 (base colour)
+		VECTOR_RASTER,		// FXVectorImage rasterized at c1*c2 pixels
+		IMAGE_WRAPPED,		// FXImage client buffer used in place (pre-multiplied ARGB32)
+	};
+
+	struct Key {
+		const void * obj;
+		FXuint kind;
+		FXColor c1;
+		FXColor c2;
+		const void * data;	// Stamp (client data pointer, with w, h and xid)
+		FXint w;
+		FXint h;
+		FXID xid;			// X id of obj, 0 if not a created FOX object
+	};
+
+protected:
+	struct ImageEntry : public Entry {
+		Key key;
+		cairo_surface_t * surf;
+	};
+
+	static FXuint hashKey(const Key & key);
+	virtual FXbool match(const Entry * e, const void * key) const;
+	virtual FXbool stale(const Entry * e, const void * key) const;
+	virtual void destroy(Entry * e);
+
+public:
+	FXCairoImageCache(FXuval bud = 16*1024*1024, FXuint maxent = 1024);
+
+	/// Return new reference to cached surface, or NULL
+	cairo_surface_t * lookup(const Key & key);
+
+	/// Store surface for key.  The cache takes its own reference.  A wrapped
+	/// buffer (IMAGE_WRAPPED) is only charged for the entry, not the pixels.
+	void store(const Key & key, cairo_surface_t * s);
+
+	/// Remove all entries for obj
+	void invalidate(const void * obj);
+
+	virtual ~FXCairoImageCache();
+};
+
+/**
+* Cache of shaped Pango layouts, so that the same strings (labels, axis ticks,
+* table cells) drawn again in the same font are not reshaped every time.
+*
+* The key is the font description and the text.  All layouts are made on one
+* PangoContext owned by the cache.  Since Pango reshapes a layout whenever the
+* context's transformation or font options change, this is only useful while
+* text is drawn unrotated and unscaled; FXDCCairo uses its own layout otherwise.
+* The memory held by a layout is estimated from the length of its text.
+*/
+class FXCairoLayoutCache : public FXCairoCache
+{
+public:
+	struct Key {
+		const PangoFontDescription * pfd;
+		const FXchar * text;
+		FXuint length;
+	};
+
+protected:
+	struct LayoutEntry : public Entry {
+		PangoFontDescription * pfd;
+		FXchar * text;
+		FXuint length;
+		PangoLayout * layout;
+	};
+
+	PangoContext * context;
+
+	static FXuint hashKey(const Key & key);
+	virtual FXbool match(const Entry * e, const void * key) const;
+	virtual void destroy(Entry * e);
+
+public:
+	FXCairoLayoutCache(FXuval bud = 4*1024*1024, FXuint maxent = 2048);
+
+	/// Return cached layout for key, making it if necessary.  The layout belongs
+	/// to the cache, and is only valid until the next call.
+	PangoLayout * lookup(const Key & key);
+
+	virtual ~FXCairoLayoutCache();
+};
+
+/**
+* Cache of Pango font descriptions made from FOX fonts, shared by all DCs, so
+* that setting a font only costs a lookup, and fonts are resolved (matched to a
+* face by fontconfig) once per process rather than once per paint.
+*
+* The key is the FXFont and a fingerprint of the attributes the description is
+* made from.  If the font's attributes no longer match the fingerprint, the
+* entry is stale.  The resolved PangoFont and its metrics are only looked up
+* when first asked for.
+*/
+class FXCairoFontCache : public FXCairoCache
+{
+public:
+	struct Key {
+		const void * font;		// FXFont
+		const FXchar * family;
+		FXuint size;			// Decipoints
+		FXuint weight;
+		FXuint slant;
+		FXuint setwidth;
+	};
+
+protected:
+	struct FontEntry : public Entry {
+		Key key;				// Family is a copy
+		PangoFontDescription * pfd;
+		PangoFont * pango;		// Resolved font (NULL until needed)
+		PangoFontMetrics * metrics;
+	};
+
+	PangoContext * context;
+
+	static FXuint hashKey(const Key & key);
+	virtual FXbool match(const Entry * e, const void * key) const;
+	virtual FXbool stale(const Entry * e, const void * key) const;
+	virtual void destroy(Entry * e);
+	FontEntry * entry(const Key & key);
+
+public:
+	FXCairoFontCache(FXuint maxent = 256);
+
+	/// Return a new description of the font, not kept in any cache; the caller
+	/// frees it with pango_font_description_free()
+	static PangoFontDescription * describe(const Key & key);
+
+	/// Return description of the font, making it if necessary.  The description
+	/// belongs to the cache, and is valid until the entry is evicted (by 256
+	/// other fonts being looked up) or the cache is flushed.
+	PangoFontDescription * lookup(const Key & key);
+
+	/// Return metrics of the resolved font, or NULL if it can't be loaded.  The
+	/// metrics belong to the cache, as above.
+	PangoFontMetrics * getMetrics(const Key & key);
+
+	/// Remove entry for font
+	void invalidate(const void * font);
+
+	virtual ~FXCairoFontCache();
+};
+
+/**
+* Cache of Cairo paths converted from clip regions and masks, so that the
+* same clip set up again only costs a comparison.
+*
+* The key is an owner object (may be NULL) and the raw data the path was
+* made from, such as the bits of a mask.  Entries match if the owner
+* is the same and the data compares equal, so a new object with the same
+* content also finds the path.
+*
+* Where the data is only a summary (such as the bounds of a region), the key
+* also gives the shape itself.  The entry keeps a copy, made by copyShape(),
+* and a match must also pass sameShape().  A subclass provides these for its
+* kind of shape.
+*/
+class FXCairoPathCache : public FXCairoCache
+{
+public:
+	struct Key {
+		const void * obj;
+		const void * data;
+		FXuint size;		// Bytes of data
+		const void * shape;	// Shape to compare as well, or NULL
+	};
+
+protected:
+	struct PathEntry : public Entry {
+		const void * obj;
+		void * data;
+		FXuint size;
+		void * shape;		// Copy of the key's shape, or NULL
+		cairo_path_t * path;
+	};
+
+	static FXuint hashKey(const Key & key);
+	virtual FXbool match(const Entry * e, const void * key) const;
+	virtual void destroy(Entry * e);
+
+	/// Copy, free and compare shapes; the base class has none
+	virtual void * copyShape(const void * shape) const { return NULL; }
+	virtual void freeShape(void * shape) const { }
+	virtual FXbool sameShape(const void * a, const void * b) const { return FALSE; }
+
+public:
+	FXCairoPathCache(FXuval bud = 1024*1024, FXuint maxent = 64);
+
+	/// Return cached path, or NULL.  The path belongs to the cache, and is
+	/// only valid until the next call to store().
+	cairo_path_t * lookup(const Key & key);
+
+	/// Store path for key.  The cache takes ownership of the path.
+	void store(const Key & key, cairo_path_t * path);
+
+	/// Remove all entries for obj
+	void invalidate(const void * obj);
+
+	virtual ~FXCairoPathCache();
+};
+
+}
+
+#endif
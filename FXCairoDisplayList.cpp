@@ -0,0 +1,248 @@
+/********************************************************************************
+*                                                                               *
+*                      C a i r o   D i s p l a y   L i s t                      *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2013 by Stephen J. Hardy.   All Rights Reserved.                *
+*********************************************************************************
+* This library is free software; you can redistribute it and/or                 *
+* modify it under the terms of the GNU Lesser General Public                    *
+* License as published by the Free Software Foundation; either                  *
+* version 2.1 of the License, or (at your option) any later version.            *
+*                                                                               *
+* This library is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU             *
+* Lesser General Public License for more details.                               *
+*                                                                               *
+* You should have received a copy of the GNU Lesser General Public              *
+* License along with this library; if not, write to the Free Software           *
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.    *
+*********************************************************************************
+* $Id: $                     *
+********************************************************************************/
+
+#include "xincs.h"
+#include "fxver.h"
+#include "fxdefs.h"
+#include "FXHash.h"
+#include "FXThread.h"
+#include "FXStream.h"
+#include "FXString.h"
+#include "FXPoint.h"
+#include "FXRectangle.h"
+#include "FXRegistry.h"
+#include "FXApp.h"
+#include "FXId.h"
+#include "FXFont.h"
+#include "FXDrawable.h"
+#include "FXDC.h"
+#include "FXDCWindow.h"
+
+#include "xincs_cairo.h"
+
+#include "config.h"
+#include "FXDCCairo.h"
+#include "FXCairoDisplayList.h"
+
+
+/*
+  Notes:
+  - The size estimate is counted from the calls, without looking at the path
+    Cairo has built: paint() and paintTextLayout() count a fixed overhead per
+    operation, with a guess for the path of a simple shape or per character
+    of text.  The calls taking arrays add a guess for the path of each item.
+    drawTexts() shows its layouts without paintTextLayout() unless the font
+    is rotated, so it counts one operation and its characters itself.
+    Drawing which bypasses paint() (images, icons, areas) only counts the
+    overhead.
+*/
+
+#define OP_BYTES 64			// Guess at per-operation overhead of a recording
+#define GLYPH_BYTES 24		// Guess at cost of each glyph of text
+#define PATH_DATA sizeof(cairo_path_data_t)
+#define SHAPE_BYTES (20*PATH_DATA)	// Simple shape; an ellipse is a move, four curves and a close
+#define POINT_BYTES (2*PATH_DATA)	// Each vertex of lines or a polygon
+#define RECT_BYTES (9*PATH_DATA)	// Rectangle: move, three lines and close
+
+using namespace FX;
+
+namespace FX
+{
+
+
+// Construct empty list
+FXCairoDisplayList::FXCairoDisplayList():
+	recording(NULL),
+	bytes(0),
+	ops(0)
+{
+}
+
+
+// Discard recording
+void FXCairoDisplayList::invalidate()
+{
+	if (recording)
+		cairo_surface_destroy((cairo_surface_t *)recording);
+	recording = NULL;
+	bytes = 0;
+	ops = 0;
+}
+
+
+FXCairoDisplayList::~FXCairoDisplayList()
+{
+	invalidate();
+}
+
+
+/*******************************************************************************/
+
+
+// New recording surface
+void * FXDCCairoRecorder::createRecording()
+{
+	return cairo_recording_surface_create(CAIRO_CONTENT_COLOR_ALPHA, NULL);
+}
+
+
+// Construct recorder
+FXDCCairoRecorder::FXDCCairoRecorder(FXDrawable* drawable,FXCairoDisplayList& l):
+	FXDCCairo(drawable, createRecording()),
+	list(&l),
+	bytes(0),
+	ops(0)
+{
+	cairo_surface_destroy(csurf);	// Drop reference from createRecording(); DC has its own
+}
+
+
+// Count operation, then paint as usual
+void FXDCCairoRecorder::paint(FXbool stroke, FXbool fill, FXbool preserve)
+{
+	bytes += OP_BYTES + SHAPE_BYTES;
+	++ops;
+	FXDCCairo::paint(stroke, fill, preserve);
+}
+
+
+// Count the path of each item of the calls taking arrays
+void FXDCCairoRecorder::drawPoints(const FXPoint* points,FXuint npoints)
+{
+	bytes += npoints*RECT_BYTES;
+	FXDCCairo::drawPoints(points, npoints);
+}
+
+
+void FXDCCairoRecorder::drawPointsRel(const FXPoint* points,FXuint npoints)
+{
+	bytes += npoints*RECT_BYTES;
+	FXDCCairo::drawPointsRel(points, npoints);
+}
+
+
+void FXDCCairoRecorder::drawLines(const FXPoint* points,FXuint npoints)
+{
+	bytes += npoints*POINT_BYTES;
+	FXDCCairo::drawLines(points, npoints);
+}
+
+
+void FXDCCairoRecorder::drawLinesRel(const FXPoint* points,FXuint npoints)
+{
+	bytes += npoints*POINT_BYTES;
+	FXDCCairo::drawLinesRel(points, npoints);
+}
+
+
+void FXDCCairoRecorder::drawLineSegments(const FXSegment* segments,FXuint nsegments)
+{
+	bytes += nsegments*2*POINT_BYTES;
+	FXDCCairo::drawLineSegments(segments, nsegments);
+}
+
+
+void FXDCCairoRecorder::drawRectangles(const FXRectangle* rectangles,FXuint nrectangles)
+{
+	bytes += nrectangles*RECT_BYTES;
+	FXDCCairo::drawRectangles(rectangles, nrectangles);
+}
+
+
+void FXDCCairoRecorder::drawArcs(const FXArc* arcs,FXuint narcs)
+{
+	bytes += narcs*SHAPE_BYTES;
+	FXDCCairo::drawArcs(arcs, narcs);
+}
+
+
+void FXDCCairoRecorder::fillRectangles(const FXRectangle* rectangles,FXuint nrectangles)
+{
+	bytes += nrectangles*RECT_BYTES;
+	FXDCCairo::fillRectangles(rectangles, nrectangles);
+}
+
+
+void FXDCCairoRecorder::fillChords(const FXArc* chords,FXuint nchords)
+{
+	bytes += nchords*SHAPE_BYTES;
+	FXDCCairo::fillChords(chords, nchords);
+}
+
+
+void FXDCCairoRecorder::fillArcs(const FXArc* arcs,FXuint narcs)
+{
+	bytes += narcs*SHAPE_BYTES;
+	FXDCCairo::fillArcs(arcs, narcs);
+}
+
+
+// The other polygon calls come here
+void FXDCCairoRecorder::fillComplexPolygon(const FXPoint* points,FXuint npoints)
+{
+	bytes += npoints*POINT_BYTES;
+	FXDCCairo::fillComplexPolygon(points, npoints);
+}
+
+
+void FXDCCairoRecorder::fillComplexPolygonRel(const FXPoint* points,FXuint npoints)
+{
+	bytes += npoints*POINT_BYTES;
+	FXDCCairo::fillComplexPolygonRel(points, npoints);
+}
+
+
+// Rotated text goes through paintTextLayout(), which counts it
+void FXDCCairoRecorder::drawTexts(const FXCairoText* texts,FXuint ntexts)
+{
+	if (font && !font->getAngle() && ntexts) {
+		bytes += OP_BYTES;
+		++ops;
+		for (FXuint i = 0; i < ntexts; ++i)
+			bytes += g_utf8_strlen(texts[i].text, texts[i].length)*GLYPH_BYTES;
+	}
+	FXDCCairo::drawTexts(texts, ntexts);
+}
+
+
+// Count glyphs, then paint as usual
+void FXDCCairoRecorder::paintTextLayout(double x, double y, FXbool fillbg)
+{
+	bytes += OP_BYTES + pango_layout_get_character_count(tlayout)*GLYPH_BYTES;
+	++ops;
+	FXDCCairo::paintTextLayout(x, y, fillbg);
+}
+
+
+// Hand over recording
+FXDCCairoRecorder::~FXDCCairoRecorder()
+{
+	cairo_surface_flush(csurf);
+	list->invalidate();
+	list->recording = cairo_surface_reference(csurf);
+	list->bytes = bytes;
+	list->ops = ops;
+}
+
+}
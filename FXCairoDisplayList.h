@@ -0,0 +1,141 @@
+/********************************************************************************
+*                                                                               *
+*                      C a i r o   D i s p l a y   L i s t                      *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2013 by Stephen J. Hardy.   All Rights Reserved.                *
+*********************************************************************************
+* This library is free software; you can redistribute it and/or                 *
+* modify it under the terms of the GNU Lesser General Public                    *
+* License as published by the Free Software Foundation; either                  *
+* version 2.1 of the License, or (at your option) any later version.            *
+*                                                                               *
+* This library is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU             *
+* Lesser General Public License for more details.                               *
+*                                                                               *
+* You should have received a copy of the GNU Lesser General Public              *
+* License along with this library; if not, write to the Free Software           *
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.    *
+*********************************************************************************
+* $Id: $                        *
+********************************************************************************/
+#ifndef FXCAIRODISPLAYLIST_H
+#define FXCAIRODISPLAYLIST_H
+
+#ifndef FXDCCAIRO_H
+#include "FXDCCairo.h"
+#endif
+
+namespace FX
+{
+
+
+/**
+* A recorded sequence of drawing, which can be drawn again cheaply.
+*
+* Widgets which draw the same thing on every expose can record their drawing
+* once with an FXDCCairoRecorder, then draw the list with
+* FXDCCairo::drawDisplayList() until the content changes and the list is
+* invalidated.  Drawing a list replays Cairo operations: text is already laid
+* out, images already converted, and none of the FXDC calls are repeated.
+*
+*   if (!list.isValid()) {
+*     FXDCCairoRecorder rec(this, list);
+*     drawContent(rec);
+*   }
+*   FXDCCairo dc(this, event);
+*   dc.drawDisplayList(list);
+*
+* The list is held in a Cairo recording surface.  getMemorySize() is an
+* estimate, from the paths and text recorded; images drawn are referenced by
+* the recording, and may be shared with FXDCCairo's image cache.
+*/
+class FXAPI FXCairoDisplayList
+{
+	friend class FXDCCairoRecorder;
+protected:
+	void * recording;		// cairo_surface_t *, NULL if invalid
+	FXuval bytes;			// Estimated size
+	FXuint ops;				// Drawing operations recorded
+
+private:
+	FXCairoDisplayList(const FXCairoDisplayList&);
+	FXCairoDisplayList &operator=(const FXCairoDisplayList&);
+public:
+
+	/// Construct empty (invalid) list
+	FXCairoDisplayList();
+
+	/// Return TRUE if something has been recorded since the last invalidate()
+	FXbool isValid() const { return recording != NULL; }
+
+	/// Discard the recording
+	void invalidate();
+
+	/// Estimated memory held by the recording, in bytes
+	FXuval getMemorySize() const { return bytes; }
+
+	/// Number of drawing operations recorded
+	FXuint getOperations() const { return ops; }
+
+	/// The recording surface (cairo_surface_t *), or NULL
+	void * getRecording() const { return recording; }
+
+	/// Destructor
+	~FXCairoDisplayList();
+};
+
+
+/**
+* Device context which records drawing into an FXCairoDisplayList, instead
+* of drawing on the drawable.  The drawable is only needed to construct the
+* DC, as for FXDCCairoImage.  Any previous recording in the list is replaced
+* when the recorder is destroyed.
+*/
+class FXAPI FXDCCairoRecorder : public FXDCCairo
+{
+protected:
+	FXCairoDisplayList * list;
+	FXuval bytes;
+	FXuint ops;
+
+	virtual void paint(FXbool stroke=TRUE, FXbool fill=FALSE, FXbool preserve=FALSE);
+	virtual void paintTextLayout(double x, double y, FXbool fillbg=FALSE);
+
+	static void * createRecording();
+
+private:
+	FXDCCairoRecorder();
+	FXDCCairoRecorder(const FXDCCairoRecorder&);
+	FXDCCairoRecorder &operator=(const FXDCCairoRecorder&);
+public:
+
+	/// Construct to record into list
+	FXDCCairoRecorder(FXDrawable* drawable,FXCairoDisplayList& list);
+
+	/// Drawing with arrays; counted, then drawn as usual
+	virtual void drawPoints(const FXPoint* points,FXuint npoints);
+	virtual void drawPointsRel(const FXPoint* points,FXuint npoints);
+	virtual void drawLines(const FXPoint* points,FXuint npoints);
+	virtual void drawLinesRel(const FXPoint* points,FXuint npoints);
+	virtual void drawLineSegments(const FXSegment* segments,FXuint nsegments);
+	virtual void drawRectangles(const FXRectangle* rectangles,FXuint nrectangles);
+	virtual void drawArcs(const FXArc* arcs,FXuint narcs);
+	virtual void fillRectangles(const FXRectangle* rectangles,FXuint nrectangles);
+	virtual void fillChords(const FXArc* chords,FXuint nchords);
+	virtual void fillArcs(const FXArc* arcs,FXuint narcs);
+	virtual void fillComplexPolygon(const FXPoint* points,FXuint npoints);
+	virtual void fillComplexPolygonRel(const FXPoint* points,FXuint npoints);
+
+	/// Many strings; counted per character, then drawn as usual
+	virtual void drawTexts(const FXCairoText* texts,FXuint ntexts);
+
+	/// Destructor; hands the recording to the list
+	virtual ~FXDCCairoRecorder();
+};
+
+}
+
+#endif
@@ -0,0 +1,609 @@
+/********************************************************************************
+*                                                                               *
+*         P i x e l   C o n v e r s i o n   F o r   Cairo surfaces              *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2013 by Stephen J. Hardy.   All Rights Reserved.                *
+*********************************************************************************
+* This library is free software; you can redistribute it and/or                 *
+* modify it under the terms of the GNU Lesser General Public                    *
+* License as published by the Free Software Foundation; either                  *
+* version 2.1 of the License, or (at your option) any later version.            *
+*                                                                               *
+* This library is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU             *
+* Lesser General Public License for more details.                               *
+*                                                                               *
+* You should have received a copy of the GNU Lesser General Public              *
+* License along with this library; if not, write to the Free Software           *
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.    *
+*********************************************************************************
+* $Id: $                     *
+********************************************************************************/
+
+#include "xincs.h"
+#include "fxver.h"
+#include "fxdefs.h"
+
+#include "FXThread.h"
+
+#include "config.h"
+#include "FXCairoPixels.h"
+#include "FXCairoThreadPool.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && !defined(FXCAIRO_NO_SIMD)
+#define FXCAIRO_X86_SIMD 1
+#include <immintrin.h>
+#define FXSSE2 __attribute__((target("sse2")))
+#define FXAVX2 __attribute__((target("avx2")))
+#endif
+
+
+/*
+  Notes:
+  - Pre-multiplication is (a*c + 128)/255, truncated.  The vector versions compute
+    this without division as ((a*c + 128) * 0x8081) >> 23, which is exact for all
+    8 bit a and c (a*c + 128 fits in 16 bits, so SIMD uses mulhi_epu16 then >> 7).
+  - FXColor is R,G,B,A in memory order; Cairo ARGB32 (little-endian) is B,G,R,A.
+    The alpha lane is "pre-multiplied" by 255, which leaves it unchanged.
+  - Each kernel converts a single row of n pixels; the row loops and the
+    kernel selection are common to all versions.
+  - Large conversions are split into about four bands per thread, so that a
+    thread which is slow to start does not hold up the rest.  The pool is made
+    on first use.  Only one conversion at a time can use it; any other which
+    comes along meanwhile (from another thread) just runs on its own thread.
+*/
+
+#define PARALLEL_THRESHOLD (1024*1024)	// Default pixels from which to use threads
+#define BANDS_PER_THREAD 4
+
+using namespace FX;
+
+namespace FX
+{
+
+
+// Convert one pixel to ARGB32
+FXuint fxColorToARGB32(FXColor clr)
+{
+	// Writes 4 bytes at dest with Cairo ARGB32 format.
+	// ARGB32 has pre-multiplied alpha in the color components.
+	FXuint a = FXALPHAVAL(clr);
+	FXuint r = (a * FXREDVAL(clr) + 128)/255;
+	FXuint g = (a * FXGREENVAL(clr) + 128)/255;
+	FXuint b = (a * FXBLUEVAL(clr) + 128)/255;
+	return a<<24 | r<<16 | g<<8 | b;
+}
+
+
+// Convert one pre-multiplied ARGB32 pixel back to FXColor
+FXColor fxARGB32ToColor(FXuint px)
+{
+	FXuint a = px>>24;
+	if (!a)
+		return 0;
+	if (a == 255)
+		return FXRGB((px>>16)&255, (px>>8)&255, px&255);
+	FXuint r = (((px>>16)&255)*255 + a/2)/a;
+	FXuint g = (((px>>8)&255)*255 + a/2)/a;
+	FXuint b = ((px&255)*255 + a/2)/a;
+	return FXRGBA(FXMIN(r,255), FXMIN(g,255), FXMIN(b,255), a);
+}
+
+
+/*******************************************************************************/
+
+// Scalar row kernels
+
+static void rowARGB32(const FXColor * f, FXuint * c, FXuint n)
+{
+	for (FXuint i = 0; i < n; ++i)
+		c[i] = fxColorToARGB32(f[i]);
+}
+
+static void rowARGB32Key(const FXColor * f, FXuint * c, FXuint n, FXColor transparent)
+{
+	for (FXuint i = 0; i < n; ++i)
+		c[i] = f[i] == transparent ? 0 : fxColorToARGB32(f[i]);
+}
+
+static void rowA8(const FXColor * f, FXuchar * c, FXuint n)
+{
+	for (FXuint i = 0; i < n; ++i)
+		c[i] = FXALPHAVAL(f[i]);
+}
+
+static void rowA1Key(const FXColor * f, FXuchar * c, FXuint n, FXColor transparent)
+{
+	// Only touches the bits for the n pixels; others in the last byte are kept.
+	FXuchar setbit = 1;
+	for (FXuint i = 0; i < n; ++i) {
+		if (!(i&7))
+			setbit = 1;
+		else
+			setbit <<= 1;
+		if (f[i] != transparent)
+			c[i>>3] |= setbit;
+		else
+			c[i>>3] &= ~setbit;
+	}
+}
+
+
+#ifdef FXCAIRO_X86_SIMD
+
+/*******************************************************************************/
+
+// SSE2 row kernels, 4 pixels per step
+
+// Pre-multiply and swizzle two pixels held as 16 bit lanes R,G,B,A,R,G,B,A
+static inline FXSSE2 __m128i premul16SSE2(__m128i x)
+{
+	const __m128i rgbmask = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+	const __m128i alpha255 = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+	__m128i a = _mm_shufflelo_epi16(x, _MM_SHUFFLE(3,3,3,3));
+	a = _mm_shufflehi_epi16(a, _MM_SHUFFLE(3,3,3,3));
+	a = _mm_or_si128(_mm_and_si128(a, rgbmask), alpha255);
+	__m128i t = _mm_add_epi16(_mm_mullo_epi16(x, a), _mm_set1_epi16(128));
+	t = _mm_srli_epi16(_mm_mulhi_epu16(t, _mm_set1_epi16((short)0x8081)), 7);
+	t = _mm_shufflelo_epi16(t, _MM_SHUFFLE(3,0,1,2));
+	return _mm_shufflehi_epi16(t, _MM_SHUFFLE(3,0,1,2));
+}
+
+static inline FXSSE2 __m128i premulSSE2(__m128i px)
+{
+	const __m128i zero = _mm_setzero_si128();
+	__m128i lo = premul16SSE2(_mm_unpacklo_epi8(px, zero));
+	__m128i hi = premul16SSE2(_mm_unpackhi_epi8(px, zero));
+	return _mm_packus_epi16(lo, hi);
+}
+
+static FXSSE2 void rowARGB32SSE2(const FXColor * f, FXuint * c, FXuint n)
+{
+	FXuint i = 0;
+	for (; i + 4 <= n; i += 4) {
+		__m128i px = _mm_loadu_si128((const __m128i *)(f + i));
+		_mm_storeu_si128((__m128i *)(c + i), premulSSE2(px));
+	}
+	rowARGB32(f + i, c + i, n - i);
+}
+
+static FXSSE2 void rowARGB32KeySSE2(const FXColor * f, FXuint * c, FXuint n, FXColor transparent)
+{
+	const __m128i key = _mm_set1_epi32((int)transparent);
+	FXuint i = 0;
+	for (; i + 4 <= n; i += 4) {
+		__m128i px = _mm_loadu_si128((const __m128i *)(f + i));
+		__m128i r = _mm_andnot_si128(_mm_cmpeq_epi32(px, key), premulSSE2(px));
+		_mm_storeu_si128((__m128i *)(c + i), r);
+	}
+	rowARGB32Key(f + i, c + i, n - i, transparent);
+}
+
+static FXSSE2 void rowA8SSE2(const FXColor * f, FXuchar * c, FXuint n)
+{
+	FXuint i = 0;
+	for (; i + 16 <= n; i += 16) {
+		__m128i a = _mm_srli_epi32(_mm_loadu_si128((const __m128i *)(f + i)), 24);
+		__m128i b = _mm_srli_epi32(_mm_loadu_si128((const __m128i *)(f + i + 4)), 24);
+		__m128i d = _mm_srli_epi32(_mm_loadu_si128((const __m128i *)(f + i + 8)), 24);
+		__m128i e = _mm_srli_epi32(_mm_loadu_si128((const __m128i *)(f + i + 12)), 24);
+		__m128i r = _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(d, e));
+		_mm_storeu_si128((__m128i *)(c + i), r);
+	}
+	rowA8(f + i, c + i, n - i);
+}
+
+static FXSSE2 void rowA1KeySSE2(const FXColor * f, FXuchar * c, FXuint n, FXColor transparent)
+{
+	const __m128i key = _mm_set1_epi32((int)transparent);
+	FXuint i = 0;
+	for (; i + 8 <= n; i += 8) {
+		FXint m0 = _mm_movemask_ps(_mm_castsi128_ps(
+			_mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)(f + i)), key)));
+		FXint m1 = _mm_movemask_ps(_mm_castsi128_ps(
+			_mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)(f + i + 4)), key)));
+		c[i>>3] = (FXuchar)~(m0 | m1<<4);
+	}
+	rowA1Key(f + i, c + (i>>3), n - i, transparent);
+}
+
+
+/*******************************************************************************/
+
+// AVX2 row kernels, 8 pixels per step.  Unpack and pack work within 128 bit
+// lanes, so pixel order is preserved without any cross-lane permutes except
+// for the A8 narrowing.
+
+static inline FXAVX2 __m256i premul16AVX2(__m256i x)
+{
+	const __m256i rgbmask = _mm256_set_epi16(0, -1, -1, -1, 0, -1, -1, -1,
+	                                         0, -1, -1, -1, 0, -1, -1, -1);
+	const __m256i alpha255 = _mm256_set_epi16(255, 0, 0, 0, 255, 0, 0, 0,
+	                                          255, 0, 0, 0, 255, 0, 0, 0);
+	__m256i a = _mm256_shufflelo_epi16(x, _MM_SHUFFLE(3,3,3,3));
+	a = _mm256_shufflehi_epi16(a, _MM_SHUFFLE(3,3,3,3));
+	a = _mm256_or_si256(_mm256_and_si256(a, rgbmask), alpha255);
+	__m256i t = _mm256_add_epi16(_mm256_mullo_epi16(x, a), _mm256_set1_epi16(128));
+	t = _mm256_srli_epi16(_mm256_mulhi_epu16(t, _mm256_set1_epi16((short)0x8081)), 7);
+	t = _mm256_shufflelo_epi16(t, _MM_SHUFFLE(3,0,1,2));
+	return _mm256_shufflehi_epi16(t, _MM_SHUFFLE(3,0,1,2));
+}
+
+static inline FXAVX2 __m256i premulAVX2(__m256i px)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	__m256i lo = premul16AVX2(_mm256_unpacklo_epi8(px, zero));
+	__m256i hi = premul16AVX2(_mm256_unpackhi_epi8(px, zero));
+	return _mm256_packus_epi16(lo, hi);
+}
+
+static FXAVX2 void rowARGB32AVX2(const FXColor * f, FXuint * c, FXuint n)
+{
+	FXuint i = 0;
+	for (; i + 8 <= n; i += 8) {
+		__m256i px = _mm256_loadu_si256((const __m256i *)(f + i));
+		_mm256_storeu_si256((__m256i *)(c + i), premulAVX2(px));
+	}
+	rowARGB32SSE2(f + i, c + i, n - i);
+}
+
+static FXAVX2 void rowARGB32KeyAVX2(const FXColor * f, FXuint * c, FXuint n, FXColor transparent)
+{
+	const __m256i key = _mm256_set1_epi32((int)transparent);
+	FXuint i = 0;
+	for (; i + 8 <= n; i += 8) {
+		__m256i px = _mm256_loadu_si256((const __m256i *)(f + i));
+		__m256i r = _mm256_andnot_si256(_mm256_cmpeq_epi32(px, key), premulAVX2(px));
+		_mm256_storeu_si256((__m256i *)(c + i), r);
+	}
+	rowARGB32KeySSE2(f + i, c + i, n - i, transparent);
+}
+
+static FXAVX2 void rowA8AVX2(const FXColor * f, FXuchar * c, FXuint n)
+{
+	const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+	FXuint i = 0;
+	for (; i + 32 <= n; i += 32) {
+		__m256i a = _mm256_srli_epi32(_mm256_loadu_si256((const __m256i *)(f + i)), 24);
+		__m256i b = _mm256_srli_epi32(_mm256_loadu_si256((const __m256i *)(f + i + 8)), 24);
+		__m256i d = _mm256_srli_epi32(_mm256_loadu_si256((const __m256i *)(f + i + 16)), 24);
+		__m256i e = _mm256_srli_epi32(_mm256_loadu_si256((const __m256i *)(f + i + 24)), 24);
+		__m256i r = _mm256_packus_epi16(_mm256_packs_epi32(a, b), _mm256_packs_epi32(d, e));
+		_mm256_storeu_si256((__m256i *)(c + i), _mm256_permutevar8x32_epi32(r, order));
+	}
+	rowA8SSE2(f + i, c + i, n - i);
+}
+
+static FXAVX2 void rowA1KeyAVX2(const FXColor * f, FXuchar * c, FXuint n, FXColor transparent)
+{
+	const __m256i key = _mm256_set1_epi32((int)transparent);
+	FXuint i = 0;
+	for (; i + 8 <= n; i += 8) {
+		FXint m = _mm256_movemask_ps(_mm256_castsi256_ps(
+			_mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i *)(f + i)), key)));
+		c[i>>3] = (FXuchar)~m;
+	}
+	rowA1Key(f + i, c + (i>>3), n - i, transparent);
+}
+
+#endif
+
+
+/*******************************************************************************/
+
+// Kernel selection
+
+struct FXPixelKernels {
+	void (*argb32)(const FXColor * f, FXuint * c, FXuint n);
+	void (*argb32key)(const FXColor * f, FXuint * c, FXuint n, FXColor transparent);
+	void (*a8)(const FXColor * f, FXuchar * c, FXuint n);
+	void (*a1key)(const FXColor * f, FXuchar * c, FXuint n, FXColor transparent);
+};
+
+static const FXPixelKernels kernelSets[] = {
+	{ rowARGB32, rowARGB32Key, rowA8, rowA1Key },
+#ifdef FXCAIRO_X86_SIMD
+	{ rowARGB32SSE2, rowARGB32KeySSE2, rowA8SSE2, rowA1KeySSE2 },
+	{ rowARGB32AVX2, rowARGB32KeyAVX2, rowA8AVX2, rowA1KeyAVX2 },
+#endif
+};
+
+// Best kernel set for this CPU
+FXuint fxCairoPixelKernelsAvailable()
+{
+#ifdef FXCAIRO_X86_SIMD
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		return FXCAIRO_PIXELS_AVX2;
+	if (__builtin_cpu_supports("sse2"))
+		return FXCAIRO_PIXELS_SSE2;
+#endif
+	return FXCAIRO_PIXELS_SCALAR;
+}
+
+
+// Selected kernel set; chosen during static initialisation, before any thread
+// can convert; a conversion from another static initialiser that runs first
+// sees zero, which is the scalar set.
+static FXuint kernelsel = fxCairoPixelKernelsAvailable();
+
+
+// Kernel set in use
+FXuint fxCairoPixelKernels()
+{
+	return kernelsel;
+}
+
+
+// Force kernel set
+FXuint fxCairoSetPixelKernels(FXuint kernels)
+{
+	kernelsel = FXMIN(kernels, fxCairoPixelKernelsAvailable());
+	return kernelsel;
+}
+
+
+static inline const FXPixelKernels & kernels()
+{
+	return kernelSets[fxCairoPixelKernels()];
+}
+
+
+/*******************************************************************************/
+
+// Splitting large conversions over threads
+
+enum {
+	JOB_ARGB32,
+	JOB_ARGB32_KEY,
+	JOB_A8,
+	JOB_A1_KEY
+};
+
+struct FXPixelJob {
+	FXuint kind;
+	FXuint rows;
+	FXuint cols;
+	const FXColor * f;
+	FXuint fstride;
+	void * c;
+	FXuint cstride;
+	FXColor transparent;
+	FXuint band;			// Rows per band
+};
+
+// Pool, deleted at exit
+struct FXPixelPool {
+	FXCairoThreadPool * pool;
+	FXuint threads;			// 0 for processors
+	FXMutex mutex;			// Held while the pool is in use
+	FXPixelPool():pool(NULL),threads(0){}
+	~FXPixelPool(){ delete pool; }
+};
+
+static FXPixelPool pixelPool;
+static FXuint parallelThreshold = PARALLEL_THRESHOLD;
+
+
+// Convert rows first..first+n-1 of job
+static void runPixelRows(const FXPixelJob & job, FXuint first, FXuint n)
+{
+	const FXPixelKernels & k = kernels();
+	const FXColor * f = (const FXColor *)((const FXuchar *)job.f + (FXuval)first*job.fstride);
+	FXuchar * c = (FXuchar *)job.c + (FXuval)first*job.cstride;
+	for (FXuint row = 0; row < n; ++row) {
+		switch (job.kind) {
+		case JOB_ARGB32:
+			k.argb32(f, (FXuint *)c, job.cols);
+			break;
+		case JOB_ARGB32_KEY:
+			k.argb32key(f, (FXuint *)c, job.cols, job.transparent);
+			break;
+		case JOB_A8:
+			k.a8(f, c, job.cols);
+			break;
+		case JOB_A1_KEY:
+			k.a1key(f, c, job.cols, job.transparent);
+			break;
+		}
+		c += job.cstride;
+		f = (const FXColor *)((const FXuchar *)f + job.fstride);
+	}
+}
+
+
+// Pool item: one band
+static void runPixelBand(void * arg, FXuint index)
+{
+	const FXPixelJob & job = *(const FXPixelJob *)arg;
+	FXuint first = index*job.band;
+	runPixelRows(job, first, FXMIN(job.band, job.rows - first));
+}
+
+
+// Convert all rows, on the pool if the job is large enough and the pool is free
+static void runPixelJob(FXPixelJob & job)
+{
+	if ((FXuval)job.rows*job.cols >= parallelThreshold && job.rows > 1 &&
+	    fxCairoPixelThreads() > 1 && pixelPool.mutex.trylock()) {
+		fxCairoPixelKernels();	// Choose before the workers look
+		if (!pixelPool.pool)
+			pixelPool.pool = new FXCairoThreadPool(pixelPool.threads);
+		FXuint nbands = FXMIN(job.rows, pixelPool.pool->getThreads()*BANDS_PER_THREAD);
+		job.band = (job.rows + nbands - 1)/nbands;
+		nbands = (job.rows + job.band - 1)/job.band;
+		pixelPool.pool->execute(runPixelBand, &job, nbands);
+		pixelPool.mutex.unlock();
+		return;
+	}
+	runPixelRows(job, 0, job.rows);
+}
+
+
+// Threads used for large conversions
+FXuint fxCairoPixelThreads()
+{
+	return pixelPool.threads ? pixelPool.threads : FXCairoThreadPool::processors();
+}
+
+
+// Set threads for large conversions
+FXuint fxCairoSetPixelThreads(FXuint n)
+{
+	pixelPool.mutex.lock();
+	if (n != pixelPool.threads) {
+		delete pixelPool.pool;
+		pixelPool.pool = NULL;
+		pixelPool.threads = n;
+	}
+	pixelPool.mutex.unlock();
+	return fxCairoPixelThreads();
+}
+
+
+// Size from which to split conversions
+FXuint fxCairoPixelParallelThreshold()
+{
+	return parallelThreshold;
+}
+
+
+// Set size from which to split conversions
+void fxCairoSetPixelParallelThreshold(FXuint pixels)
+{
+	parallelThreshold = pixels;
+}
+
+
+/*******************************************************************************/
+
+// Row loops
+
+void fxClientBitmapToCairoA1(FXuint rows,
+		FXuint fstride, const FXuchar * f,
+		FXuint cstride, FXuchar * c)
+{
+	for (FXuint row = 0; row < rows; ++row) {
+		memcpy(c, f, fstride);
+		c += cstride;
+		f += fstride;
+	}
+}
+
+
+void fxClientBitmapToCairoARGB32(FXuint rows, FXuint w,
+		FXuint fstride, const FXuchar * f,
+		FXuint cstride, FXuint * c,
+		FXColor fg, FXColor bg)
+{
+	FXuint fgc = fxColorToARGB32(fg);
+	FXuint bgc = fxColorToARGB32(bg);
+	FXuint * r;
+	FXuchar pix;
+	FXuint i;
+	for (FXuint row = 0; row < rows; ++row) {
+		r = c;
+		for (i = 0; i < w>>3; ++i) {
+			pix = f[i];
+			for (FXuint j = 0; j < 8; ++j, pix >>= 1)
+				*(r++) = pix&1 ? fgc : bgc;
+		}
+		if (w&7) {
+			pix = f[i];
+			for (FXuint j = 0; j < (w&7); ++j, pix >>= 1)
+				*(r++) = pix&1 ? fgc : bgc;
+		}
+		c = (FXuint *)((FXuchar *)c + cstride);
+		f += fstride;
+	}
+}
+
+
+void fxClientFXColorToCairoA1(FXuint rows,
+		FXuint fstride, const FXColor * f,
+		FXuint cstride, FXuchar * c,
+		FXuchar alpha_thresh,
+		FXdouble lum_thresh)
+{
+	// Fill a Cairo A1 surface with 1 bit if FXColor alpha >= alpha_thresh,
+	// and its NTSC luminescence is >= lum_thresh.
+	FXuint cols = fstride>>2;
+	FXuchar setbit = 1;
+	for (FXuint row = 0; row < rows; ++row) {
+		for (FXuint i = 0; i < cols; ++i) {
+			if (!(i&7))
+				setbit = 1;
+			else
+				setbit <<= 1;
+			if (FXALPHAVAL(f[i]) >= alpha_thresh &&
+			    FXREDVAL(f[i])*0.3 + FXGREENVAL(f[i])*0.59 + FXBLUEVAL(f[i])*0.11 >= lum_thresh)
+				c[i>>3] |= setbit;
+			else
+				c[i>>3] &= ~setbit;
+		}
+		c += cstride;
+		f += fstride>>2;
+	}
+}
+
+
+void fxClientFXColorToCairoA1(FXuint rows,
+		FXuint fstride, const FXColor * f,
+		FXuint cstride, FXuchar * c,
+		FXColor transparent)
+{
+	// Fill a Cairo A1 surface with 1 bit if FXColor is not 'transparent'.
+	FXPixelJob job = { JOB_A1_KEY, rows, fstride>>2, f, fstride, c, cstride, transparent, 0 };
+	runPixelJob(job);
+}
+
+
+void fxClientFXColorToCairoA8(FXuint rows,
+		FXuint fstride, const FXColor * f,
+		FXuint cstride, FXuchar * c)
+{
+	// Fill a Cairo A8 surface with alpha channel.
+	FXPixelJob job = { JOB_A8, rows, fstride>>2, f, fstride, c, cstride, 0, 0 };
+	runPixelJob(job);
+}
+
+
+void fxClientFXColorToCairoARGB32(FXuint rows,
+		FXuint fstride, const FXColor * f,
+		FXuint cstride, FXuint * c)
+{
+	FXPixelJob job = { JOB_ARGB32, rows, FXMIN(fstride, cstride)>>2, f, fstride, c, cstride, 0, 0 };
+	runPixelJob(job);
+}
+
+
+void fxClientFXColorTransparencyToCairoARGB32(FXuint rows,
+		FXuint fstride, const FXColor * f,
+		FXuint cstride, FXuint * c,
+		FXColor transparent)
+{
+	// Copies ARGB data directly, unless it matches the given "transparent"
+	// color, in which case it is made transparent black (0).
+	FXPixelJob job = { JOB_ARGB32_KEY, rows, FXMIN(fstride, cstride)>>2, f, fstride, c, cstride, transparent, 0 };
+	runPixelJob(job);
+}
+
+
+void fxCairoARGB32ToClientFXColor(FXuint rows,
+		FXuint cstride, const FXuint * c,
+		FXuint fstride, FXColor * f,
+		FXbool opaque)
+{
+	// Un-premultiply.  If opaque (RGB24 data), the alpha byte is ignored.
+	FXuint cols = FXMIN(fstride, cstride)>>2;
+	for (FXuint row = 0; row < rows; ++row) {
+		for (FXuint i = 0; i < cols; ++i)
+			f[i] = fxARGB32ToColor(opaque ? c[i] | 0xFF000000 : c[i]);
+		c += cstride>>2;
+		f += fstride>>2;
+	}
+}
+
+}
@@ -0,0 +1,140 @@
+/********************************************************************************
+*                                                                               *
+*         P i x e l   C o n v e r s i o n   F o r   Cairo surfaces              *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2013 by Stephen J. Hardy.   All Rights Reserved.                *
+*********************************************************************************
+* This library is free software; you can redistribute it and/or                 *
+* modify it under the terms of the GNU Lesser General Public                    *
+* License as published by the Free Software Foundation; either                  *
+* version 2.1 of the License, or (at your option) any later version.            *
+*                                                                               *
+* This library is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU             *
+* Lesser General Public License for more details.                               *
+*                                                                               *
+* You should have received a copy of the GNU Lesser General Public              *
+* License along with this library; if not, write to the Free Software           *
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.    *
+*********************************************************************************
+* $Id: $                        *
+********************************************************************************/
+#ifndef FXCAIROPIXELS_H
+#define FXCAIROPIXELS_H
+
+/*
+	Conversion of FOX client-side pixel buffers into Cairo image surface data
+	(and back).
+	This is private to the library (and its test programs).  None of these
+	functions depend on Cairo itself; they just know the Cairo pixel formats:
+
+	ARGB32: 32 bits per pixel, native endian 0xAARRGGBB, with the colour
+	        components pre-multiplied by alpha.
+	A8:     8 bits per pixel alpha.
+	A1:     1 bit per pixel alpha, least significant bit first on little-endian.
+
+	Strides are in bytes.  Where both source and destination strides are given,
+	the number of pixels converted per row is derived from the smaller one.
+
+	The ARGB32, A8 and transparent-keyed A1 conversions have SSE2 and AVX2
+	versions on x86, selected at run time.  All versions give bit-identical
+	results.
+
+	The same conversions of large images (by default, a megapixel or more) are
+	split into bands of rows, which are converted on a pool of threads.  Every
+	row is converted the same way whichever thread does it, so the result does
+	not depend on the number of threads.
+*/
+
+namespace FX
+{
+
+
+/// Pixel kernel sets
+enum {
+	FXCAIRO_PIXELS_SCALAR = 0,	// Portable C++
+	FXCAIRO_PIXELS_SSE2   = 1,	// 4 pixels at a time
+	FXCAIRO_PIXELS_AVX2   = 2	// 8 pixels at a time
+};
+
+/// Return best kernel set supported by this CPU
+extern FXAPI FXuint fxCairoPixelKernelsAvailable();
+
+/// Return kernel set currently in use
+extern FXAPI FXuint fxCairoPixelKernels();
+
+/// Select kernel set; clamped to what is available.  Returns the one selected.
+/// Not to be called while conversions are running on other threads.
+extern FXAPI FXuint fxCairoSetPixelKernels(FXuint kernels);
+
+/// Return number of threads used for large conversions
+extern FXAPI FXuint fxCairoPixelThreads();
+
+/// Set number of threads for large conversions; 0 for the number of
+/// processors (the default), 1 to convert on the calling thread only.
+/// Returns the number set.
+extern FXAPI FXuint fxCairoSetPixelThreads(FXuint n);
+
+/// Return the number of pixels from which conversions are split into bands
+extern FXAPI FXuint fxCairoPixelParallelThreshold();
+
+/// Set the number of pixels from which conversions are split into bands
+extern FXAPI void fxCairoSetPixelParallelThreshold(FXuint pixels);
+
+/// Convert one FXColor to pre-multiplied ARGB32
+extern FXAPI FXuint fxColorToARGB32(FXColor clr);
+
+/// Convert one pre-multiplied ARGB32 pixel back to FXColor
+extern FXAPI FXColor fxARGB32ToColor(FXuint px);
+
+/// FXBitmap data (rows padded to bytes) to A1
+extern FXAPI void fxClientBitmapToCairoA1(FXuint rows,
+		FXuint fstride, const FXuchar * f,
+		FXuint cstride, FXuchar * c);
+
+/// FXBitmap data to ARGB32, using fg for 1 bits and bg for 0 bits
+extern FXAPI void fxClientBitmapToCairoARGB32(FXuint rows, FXuint w,
+		FXuint fstride, const FXuchar * f,
+		FXuint cstride, FXuint * c,
+		FXColor fg, FXColor bg);
+
+/// FXColor to A1, set where alpha >= alpha_thresh and luminance >= lum_thresh
+extern FXAPI void fxClientFXColorToCairoA1(FXuint rows,
+		FXuint fstride, const FXColor * f,
+		FXuint cstride, FXuchar * c,
+		FXuchar alpha_thresh,
+		FXdouble lum_thresh);
+
+/// FXColor to A1, set where the pixel is not the transparent colour
+extern FXAPI void fxClientFXColorToCairoA1(FXuint rows,
+		FXuint fstride, const FXColor * f,
+		FXuint cstride, FXuchar * c,
+		FXColor transparent);
+
+/// FXColor alpha channel to A8
+extern FXAPI void fxClientFXColorToCairoA8(FXuint rows,
+		FXuint fstride, const FXColor * f,
+		FXuint cstride, FXuchar * c);
+
+/// FXColor to pre-multiplied ARGB32
+extern FXAPI void fxClientFXColorToCairoARGB32(FXuint rows,
+		FXuint fstride, const FXColor * f,
+		FXuint cstride, FXuint * c);
+
+/// FXColor to pre-multiplied ARGB32, with the transparent colour made transparent black
+extern FXAPI void fxClientFXColorTransparencyToCairoARGB32(FXuint rows,
+		FXuint fstride, const FXColor * f,
+		FXuint cstride, FXuint * c,
+		FXColor transparent);
+
+/// Pre-multiplied ARGB32 (or RGB24, if opaque) back to FXColor
+extern FXAPI void fxCairoARGB32ToClientFXColor(FXuint rows,
+		FXuint cstride, const FXuint * c,
+		FXuint fstride, FXColor * f,
+		FXbool opaque = FALSE);
+
+}
+
+#endif
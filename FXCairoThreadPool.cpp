@@ -0,0 +1,171 @@
+/********************************************************************************
+*                                                                               *
+*              T h r e a d   P o o l   F o r   Cairo device context             *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2013 by Stephen J. Hardy.   All Rights Reserved.                *
+*********************************************************************************
+* This library is free software; you can redistribute it and/or                 *
+* modify it under the terms of the GNU Lesser General Public                    *
+* License as published by the Free Software Foundation; either                  *
+* version 2.1 of the License, or (at your option) any later version.            *
+*                                                                               *
+* This library is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU             *
+* Lesser General Public License for more details.                               *
+*                                                                               *
+* You should have received a copy of the GNU Lesser General Public              *
+* License along with this library; if not, write to the Free Software           *
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.    *
+*********************************************************************************
+* $Id: $                     *
+********************************************************************************/
+
+#include "xincs.h"
+#include "fxver.h"
+#include "fxdefs.h"
+#include "FXThread.h"
+
+#include "FXCairoThreadPool.h"
+
+#ifndef WIN32
+#include <unistd.h>
+#endif
+
+
+/*
+  Notes:
+  - Workers sleep on 'wake' until execute() bumps the generation.  They then
+    take items one at a time under the mutex until none are left.  The calling
+    thread takes items too, so a pool of one thread has no workers at all.
+  - The function and argument are read under the mutex together with the item
+    index, so a worker which wakes late can only pick up items of the current
+    execute() call.
+*/
+
+using namespace FX;
+
+namespace FX
+{
+
+
+// Worker thread
+class FXCairoWorker : public FXThread
+{
+	FXCairoThreadPool * pool;
+public:
+	FXCairoWorker(FXCairoThreadPool * p):pool(p){}
+	virtual FXint run() { pool->work(); return 0; }
+};
+
+
+// Number of processors
+FXuint FXCairoThreadPool::processors()
+{
+#ifndef WIN32
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	return n > 0 ? (FXuint)n : 1;
+#else
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwNumberOfProcessors;
+#endif
+}
+
+
+// Start workers
+FXCairoThreadPool::FXCairoThreadPool(FXuint nthreads):
+	fn(NULL),
+	arg(NULL),
+	count(0),
+	next(0),
+	finished(0),
+	generation(0),
+	stopping(FALSE)
+{
+	if (!nthreads)
+		nthreads = processors();
+	nworkers = nthreads - 1;
+	FXMALLOC(&workers, FXCairoWorker *, nworkers+1);
+	for (FXuint i = 0; i < nworkers; ++i) {
+		workers[i] = new FXCairoWorker(this);
+		workers[i]->start();
+	}
+}
+
+
+// Run items until there are none left to start
+void FXCairoThreadPool::runItems()
+{
+	mutex.lock();
+	while (next < count) {
+		FXuint i = next++;
+		Work f = fn;
+		void * a = arg;
+		mutex.unlock();
+		f(a, i);
+		mutex.lock();
+		if (++finished == count)
+			done.broadcast();
+	}
+	mutex.unlock();
+}
+
+
+// Worker loop
+void FXCairoThreadPool::work()
+{
+	mutex.lock();
+	FXuint seen = generation;
+	for (;;) {
+		while (!stopping && generation == seen)
+			wake.wait(mutex);
+		if (stopping)
+			break;
+		seen = generation;
+		mutex.unlock();
+		runItems();
+		mutex.lock();
+	}
+	mutex.unlock();
+}
+
+
+// Post items, help run them, and wait for the rest
+void FXCairoThreadPool::execute(Work f, void * a, FXuint n)
+{
+	if (!n)
+		return;
+	mutex.lock();
+	fn = f;
+	arg = a;
+	count = n;
+	next = 0;
+	finished = 0;
+	++generation;
+	wake.broadcast();
+	mutex.unlock();
+	runItems();
+	mutex.lock();
+	while (finished < count)
+		done.wait(mutex);
+	mutex.unlock();
+}
+
+
+// Stop workers
+FXCairoThreadPool::~FXCairoThreadPool()
+{
+	mutex.lock();
+	stopping = TRUE;
+	wake.broadcast();
+	mutex.unlock();
+	for (FXuint i = 0; i < nworkers; ++i) {
+		workers[i]->join();
+		delete workers[i];
+	}
+	FXFREE(&workers);
+}
+
+}
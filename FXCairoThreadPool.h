@@ -0,0 +1,94 @@
+/********************************************************************************
+*                                                                               *
+*              T h r e a d   P o o l   F o r   Cairo device context             *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2013 by Stephen J. Hardy.   All Rights Reserved.                *
+*********************************************************************************
+* This library is free software; you can redistribute it and/or                 *
+* modify it under the terms of the GNU Lesser General Public                    *
+* License as published by the Free Software Foundation; either                  *
+* version 2.1 of the License, or (at your option) any later version.            *
+*                                                                               *
+* This library is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU             *
+* Lesser General Public License for more details.                               *
+*                                                                               *
+* You should have received a copy of the GNU Lesser General Public              *
+* License along with this library; if not, write to the Free Software           *
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.    *
+*********************************************************************************
+* $Id: $                        *
+********************************************************************************/
+#ifndef FXCAIROTHREADPOOL_H
+#define FXCAIROTHREADPOOL_H
+
+/*
+	Private to the library (and its test programs).  Include after fx.h.
+*/
+
+namespace FX
+{
+
+class FXCairoWorker;
+
+
+/**
+* A fixed set of worker threads for splitting work (such as the horizontal
+* bands of an image) into independent items.
+*
+* execute() runs fn(arg, i) for every i < count, spread over the workers and
+* the calling thread, and returns once all items are done.  Items may run in
+* any order.  Only one thread at a time may call execute(), and fn must not
+* call execute() on the same pool.
+*/
+class FXCairoThreadPool
+{
+public:
+	typedef void (*Work)(void * arg, FXuint index);
+
+protected:
+	FXCairoWorker ** workers;
+	FXuint nworkers;
+	FXMutex mutex;
+	FXCondition wake;		// Signalled when new work is posted, or stopping
+	FXCondition done;		// Signalled when the last item finishes
+	Work fn;
+	void * arg;
+	FXuint count;			// Items posted
+	FXuint next;			// Next item to start
+	FXuint finished;		// Items finished
+	FXuint generation;		// Bumped by each execute()
+	FXbool stopping;
+
+	void runItems();
+
+private:
+	FXCairoThreadPool(const FXCairoThreadPool&);
+	FXCairoThreadPool &operator=(const FXCairoThreadPool&);
+
+	friend class FXCairoWorker;
+	void work();
+
+public:
+	/// Construct pool running on nthreads threads, including the caller
+	/// of execute().  Zero means the number of processors.
+	FXCairoThreadPool(FXuint nthreads = 0);
+
+	/// Number of threads, including the caller
+	FXuint getThreads() const { return nworkers + 1; }
+
+	/// Run all items and wait for them
+	void execute(Work fn, void * arg, FXuint count);
+
+	/// Number of processors online
+	static FXuint processors();
+
+	/// Stop and join the workers
+	~FXCairoThreadPool();
+};
+
+}
+
+#endif
@@ -37,6 +37,7 @@
 #include "FXVisual.h"
 #include "FXFont.h"
 #include "FXDrawable.h"
+#include "FXWindow.h"
 #include "FXImage.h"
 #include "FXBitmap.h"
 #include "FXIcon.h"
@@ -48,6 +49,10 @@
 
 #include "config.h"
 #include "FXDCCairo.h"
+#include "FXCairoPixels.h"
+#include "FXCairoCache.h"
+#include "FXCairoDisplayList.h"
+#include "FXVectorImage.h"
 
 
 /*
@@ -61,12 +66,176 @@ using namespace FX;
 namespace FX
 {
 
+static cairo_surface_t * fxToCairoClient(const FXImage * b);
+static cairo_surface_t * fxWrapCairoClient(const FXImage * b);
+
+
+/*
+	Threads.
+	
+	The caches below are shared by all DCs and not locked, so they belong to the
+	thread which loaded the library (the main thread, which runs the GUI).  An
+	FXDCCairoImage may draw on another thread, and then bypasses them: images are
+	converted for each use, fonts are described by the DC itself, text is laid out
+	on the DC's own layout, and clip paths are not kept.  Drawing on a window
+	(FXDCCairo, FXDCCairoParallel) and the static measuring and cache functions
+	are for the GUI thread only, as with FOX itself.
+*/
+
+static FXThreadID cacheThread = FXThread::current();
+
+
+// Return TRUE if the shared caches may be used on this thread
+static inline FXbool fxSharedCaches()
+{
+	return FXThread::current() == cacheThread;
+}
+
+
+/*
+	Instrumentation.
+	
+	With FXDCCAIRO_INSTRUMENT, each operation in FXCairoOpStats declares an
+	FXCairoOpTimer at the start of its body, which adds the count and elapsed
+	time to the DC and to the process totals when it goes out of scope.  The
+	static conversion functions have no DC, so the timer of the public call
+	they run under records which DC that is.  The process totals and that record
+	are shared, so like the caches they are only used on the cache thread.  A DC
+	on another thread (FXDCCairoImage) only counts into its own stats, and the
+	static conversions it runs are not counted.  Without FXDCCAIRO_INSTRUMENT,
+	the macros expand to nothing.
+*/
+
+static FXCairoOpStats globalOpStats;
+
+static const FXchar * opNames[FXCairoOpStats::LAST] = {
+	"drawPoint", "drawPoints", "drawLine", "drawLines", "drawLineSegments",
+	"drawRectangle", "drawRectangles", "drawRoundRectangle", "drawArc", "drawArcs",
+	"drawEllipse", "fillRectangle", "fillRectangles", "fillRoundRectangle",
+	"fillChord", "fillChords", "fillArc", "fillArcs", "fillEllipse", "fillPolygon",
+	"drawHashBox", "drawFocusRectangle", "drawArea", "drawImage", "drawDisplayList",
+	"drawVectorImage",
+	"drawBitmap", "drawIcon", "drawIconShaded", "drawIconSunken", "drawText",
+	"drawTexts", "drawImageText", "setClipRegion", "setClipMask", "readPixel", "paint",
+	"paintText", "textLayout", "convert", "iconSurface", "serverSurface",
+	"updateTransform", "measureText"
+};
+
+#ifdef FXDCCAIRO_INSTRUMENT
+
+static FXCairoOpStats * currentOpStats;	// DC whose operation is running
+
+class FXCairoOpTimer {
+	FXCairoOpStats * stats;
+	FXCairoOpStats * outer;
+	FXbool shared;				// On the cache thread
+	FXuint op;
+	FXTime start;
+public:
+	FXCairoOpTimer(FXCairoOpStats * s, FXuint o):
+		stats(s), outer(NULL), shared(fxSharedCaches()), op(o), start(FXThread::time())
+	{
+		if (shared) {
+			outer = currentOpStats;
+			if (stats)
+				currentOpStats = stats;
+		}
+	}
+	~FXCairoOpTimer()
+	{
+		FXTime t = FXThread::time() - start;
+		if (stats) {
+			++stats->count[op];
+			stats->time[op] += t;
+		}
+		if (shared) {
+			++globalOpStats.count[op];
+			globalOpStats.time[op] += t;
+			currentOpStats = outer;
+		}
+	}
+};
+
+#define INSTRUMENT(op) FXCairoOpTimer instrument_(opstats, FXCairoOpStats::op)
+#define INSTRUMENT_STATIC(op) FXCairoOpTimer instrument_(fxSharedCaches() ? currentOpStats : NULL, FXCairoOpStats::op)
+
+#else
+
+#define INSTRUMENT(op)
+#define INSTRUMENT_STATIC(op)
+
+#endif
+
+
+// Does the library keep operation counts
+FXbool FXDCCairo::isInstrumented()
+{
+#ifdef FXDCCAIRO_INSTRUMENT
+	return TRUE;
+#else
+	return FALSE;
+#endif
+}
+
+
+// Get operation counts of this DC
+void FXDCCairo::getOpStats(FXCairoOpStats & stats) const
+{
+	if (opstats)
+		stats = *opstats;
+	else
+		memset(&stats, 0, sizeof(stats));
+}
+
+
+// Reset operation counts of this DC
+void FXDCCairo::resetOpStats()
+{
+	if (opstats)
+		memset(opstats, 0, sizeof(FXCairoOpStats));
+}
+
+
+// Get process operation counts
+void FXDCCairo::getGlobalOpStats(FXCairoOpStats & stats)
+{
+	stats = globalOpStats;
+}
+
+
+// Reset process operation counts
+void FXDCCairo::resetGlobalOpStats()
+{
+	memset(&globalOpStats, 0, sizeof(globalOpStats));
+}
+
+
+// Name of operation
+const FXchar * FXDCCairo::getOpName(FXuint op)
+{
+	return op < FXCairoOpStats::LAST ? opNames[op] : "";
+}
+
+
+// Print used operations
+void FXDCCairo::dumpOpStats(const FXCairoOpStats & stats, FILE * fp)
+{
+	for (FXuint op = 0; op < FXCairoOpStats::LAST; ++op) {
+		if (!stats.count[op])
+			continue;
+		fprintf(fp, "%s %u %lld %.0f\n", opNames[op], stats.count[op], (long long)stats.time[op],
+			(double)stats.time[op]/stats.count[op]);
+	}
+}
+
 
 
 
 // Construct for expose event painting
 FXDCCairo::FXDCCairo(FXDrawable* drawable,FXEvent* event):
-	FXDCWindow(drawable, event)
+	FXDCWindow(drawable, event),
+	opstats(NULL),
+	cr_xform(0)
 {
 	begin(drawable);
 	cairo_rectangle(cc, rect.x, rect.y, rect.w, rect.h);
@@ -76,22 +245,37 @@ FXDCCairo::FXDCCairo(FXDrawable* drawable,FXEvent* event):
 
 // Construct for normal painting
 FXDCCairo::FXDCCairo(FXDrawable* drawable):
-	FXDCWindow(drawable)
+	FXDCWindow(drawable),
+	opstats(NULL),
+	cr_xform(0)
 {
 	begin(drawable);
 }
 
 
+// Construct for drawing on a Cairo surface.  FXDCWindow needs a created
+// drawable, so the proxy is only used for that.
+FXDCCairo::FXDCCairo(FXDrawable* proxy,void* target):
+	FXDCWindow(proxy),
+	opstats(NULL),
+	cr_xform(0)
+{
+	beginSurface(target);
+}
+
+
 // Destruct
 FXDCCairo::~FXDCCairo()
 {
 	end();
 	FXDCWindow::end();
+	FXFREE(&opstats);
 }
 
 
 void * FXDCCairo::createServerSurface(const FXDrawable * d)
 {
+	INSTRUMENT(SERVER_SURFACE);
 #ifndef WIN32
 	return cairo_xlib_surface_create(
 	          DISPLAY(getApp()),
@@ -105,6 +289,220 @@ void * FXDCCairo::createServerSurface(const FXDrawable * d)
 }
 
 
+// Surface of client side pixels of an image, or NULL if it has none
+void * FXDCCairo::createClientSurface(const FXDrawable * d)
+{
+	if (!d->isMemberOf(FXMETACLASS(FXImage)) || !((const FXImage *)d)->getData())
+		return NULL;
+	if (isImagePremultiplied((const FXImage *)d))
+		return fxWrapCairoClient((const FXImage *)d);
+	cairo_surface_t * s = fxToCairoClient((const FXImage *)d);
+	if (!s)
+		return NULL;
+	// Conversions have an extra row (see fxToCairoClient), which would spoil tiling
+	cairo_surface_t * ss = cairo_surface_create_for_rectangle(s, 0, 0, d->getWidth(), d->getHeight());
+	cairo_surface_destroy(s);
+	return ss;
+}
+
+
+// Surface to draw from: the client pixels of pre-multiplied images, else as
+// the subclass chooses
+void * FXDCCairo::createSourceSurface(const FXDrawable * d)
+{
+	if (d->isMemberOf(FXMETACLASS(FXImage)) && isImagePremultiplied((const FXImage *)d)) {
+		void * s = createClientSurface(d);
+		if (s)
+			return s;
+	}
+	return createServerSurface(d);
+}
+
+
+// Recording (display list or vector image) about to be drawn
+void * FXDCCairo::useRecording(void * recording)
+{
+	return recording;
+}
+
+
+/*
+	Drawable surface cache.
+	
+	Creating an Xlib surface, a cairo_t and a PangoLayout for every expose event is
+	a significant part of the cost of a small paint.  So, the objects made for a
+	drawable are kept in a small LRU table, keyed by the drawable and its id.  A
+	cached entry is considered stale if the drawable's id or size has changed.
+	
+	A drawable may be deleted, and another made at the same address, without
+	releaseSurface() being called.  Entries for windows are checked against the
+	application's table of live windows, which a window leaves when it is
+	destroyed: on every lookup of the entry, and for all entries whenever a new
+	one is stored, so a destroyed window's Xlib surface does not stay in the
+	table.  The stale entry is never dereferenced, only its id looked up.  Other
+	drawables (pixmaps) are only caught by a change of id, or age out.
+	
+	The table, like the other caches, is for the GUI thread only.
+	
+	The cairo_t is reused across DCs: begin() does a cairo_save() and end() does a
+	cairo_restore(), so that each DC starts with the default Cairo state.  An entry
+	is marked busy while a DC is using it; a second DC on the same drawable (which
+	is unusual) just gets its own uncached objects.
+*/
+
+#define SURFACE_CACHE_SIZE 16
+
+struct FXCairoSurfaceEntry {
+	const FXDrawable * drawable;	// Drawable which surface was created for (NULL if free)
+	FXID id;						// Its id at that time
+	FXint w;						// Its size at that time
+	FXint h;
+	cairo_surface_t * surf;
+	cairo_t * cc;
+	PangoLayout * layout;
+	FXApp * app;					// Application of a window, NULL for other drawables
+	FXuint stamp;					// Last use, for LRU replacement
+	FXbool busy;					// In use by a DC
+};
+
+static FXCairoSurfaceEntry surfaceCache[SURFACE_CACHE_SIZE];
+static FXCairoCacheStats surfaceStats;
+static FXuint surfaceStamp = 0;
+
+
+// Destroy cached objects and free the slot
+static void fxFreeSurfaceEntry(FXCairoSurfaceEntry * e)
+{
+	g_object_unref(e->layout);
+	cairo_destroy(e->cc);
+	cairo_surface_destroy(e->surf);
+	memset(e, 0, sizeof(FXCairoSurfaceEntry));
+	--surfaceStats.entries;
+}
+
+
+// Return TRUE if the entry is for a window which has since been destroyed
+static inline FXbool fxDeadWindow(const FXCairoSurfaceEntry * e)
+{
+	return e->app && e->app->findWindowWithId(e->id) != e->drawable;
+}
+
+
+// Find a usable cached entry for the drawable, and mark it busy
+static FXCairoSurfaceEntry * fxLookupSurface(const FXDrawable * d)
+{
+#ifndef WIN32
+	for (FXuint i = 0; i < SURFACE_CACHE_SIZE; ++i) {
+		FXCairoSurfaceEntry * e = surfaceCache + i;
+		if (e->drawable != d)
+			continue;
+		if (e->busy)
+			break;
+		if (e->id != d->id() || e->w != d->getWidth() || e->h != d->getHeight() ||
+		    fxDeadWindow(e) || cairo_status(e->cc) != CAIRO_STATUS_SUCCESS) {
+			fxFreeSurfaceEntry(e);
+			++surfaceStats.evictions;
+			break;
+		}
+		e->stamp = ++surfaceStamp;
+		e->busy = TRUE;
+		++surfaceStats.hits;
+		return e;
+	}
+#endif
+	++surfaceStats.misses;
+	return NULL;
+}
+
+
+// Store newly created objects for the drawable.  Returns NULL if they could not
+// be cached, in which case the caller owns them.
+static FXCairoSurfaceEntry * fxStoreSurface(const FXDrawable * d, cairo_surface_t * surf,
+		cairo_t * cc, PangoLayout * layout)
+{
+#ifndef WIN32
+	FXCairoSurfaceEntry * e = NULL;
+	for (FXuint i = 0; i < SURFACE_CACHE_SIZE; ++i) {
+		FXCairoSurfaceEntry * f = surfaceCache + i;
+		if (f->drawable && !f->busy && fxDeadWindow(f)) {
+			fxFreeSurfaceEntry(f);
+			++surfaceStats.evictions;
+		}
+		if (f->drawable == d)
+			return NULL;	// Busy with another DC
+		if (!f->drawable) {
+			if (!e || e->drawable)
+				e = f;
+		}
+		else if (!f->busy && (!e || (e->drawable && f->stamp < e->stamp)))
+			e = f;
+	}
+	if (!e)
+		return NULL;
+	if (e->drawable) {
+		fxFreeSurfaceEntry(e);
+		++surfaceStats.evictions;
+	}
+	e->drawable = d;
+	e->id = d->id();
+	e->w = d->getWidth();
+	e->h = d->getHeight();
+	e->surf = surf;
+	e->cc = cc;
+	e->layout = layout;
+	e->app = d->isMemberOf(FXMETACLASS(FXWindow)) ? d->getApp() : NULL;
+	e->stamp = ++surfaceStamp;
+	e->busy = TRUE;
+	++surfaceStats.entries;
+	return e;
+#else
+	return NULL;
+#endif
+}
+
+
+// Forget cached surface for drawable
+void FXDCCairo::releaseSurface(const FXDrawable * drawable)
+{
+	for (FXuint i = 0; i < SURFACE_CACHE_SIZE; ++i) {
+		FXCairoSurfaceEntry * e = surfaceCache + i;
+		if (e->drawable && e->drawable == drawable) {
+			if (e->busy)
+				e->drawable = NULL;	// Freed by end()
+			else
+				fxFreeSurfaceEntry(e);
+		}
+	}
+}
+
+
+// Release all idle cached surfaces
+void FXDCCairo::flushSurfaceCache()
+{
+	for (FXuint i = 0; i < SURFACE_CACHE_SIZE; ++i) {
+		FXCairoSurfaceEntry * e = surfaceCache + i;
+		if (e->drawable && !e->busy)
+			fxFreeSurfaceEntry(e);
+	}
+}
+
+
+// Get surface cache statistics
+void FXDCCairo::getSurfaceCacheStats(FXCairoCacheStats & stats)
+{
+	stats = surfaceStats;
+}
+
+
+// Reset surface cache counters
+void FXDCCairo::resetSurfaceCacheStats()
+{
+	surfaceStats.hits = 0;
+	surfaceStats.misses = 0;
+	surfaceStats.evictions = 0;
+}
+
+
 // Begin locks in a drawable surface
 void FXDCCairo::begin(FXDrawable *drawable)
 {
@@ -114,8 +512,53 @@ void FXDCCairo::begin(FXDrawable *drawable)
 	if(!drawable->id()) {
 		fxerror("FXDCCairo::begin: drawable not created yet.\n");
 	}
-	csurf = (cairo_surface_t *)createServerSurface(drawable);
+	centry = fxLookupSurface(drawable);
+	if (centry) {
+		csurf = centry->surf;
+		cc = centry->cc;
+		layout = centry->layout;
+	}
+	else {
+		csurf = (cairo_surface_t *)createServerSurface(drawable);
+		cc = cairo_create(csurf);
+		layout = pango_cairo_create_layout(cc);
+		centry = fxStoreSurface(drawable, csurf, cc, layout);
+	}
+	pfd = NULL;
+	cr_ownpfd = FALSE;
+	cr_font = NULL;
+	resetState();
+}
+
+
+// Begin drawing on a Cairo surface instead of the drawable
+void FXDCCairo::beginSurface(void * target)
+{
+	if(!target) {
+		fxerror("FXDCCairo::beginSurface: NULL surface.\n");
+	}
+	centry = NULL;
+	csurf = cairo_surface_reference((cairo_surface_t *)target);
 	cc = cairo_create(csurf);
+	layout = pango_cairo_create_layout(cc);
+	pfd = NULL;
+	cr_ownpfd = FALSE;
+	cr_font = NULL;
+	resetState();
+}
+
+
+// Set up initial state of a new or cached context
+void FXDCCairo::resetState()
+{
+	// Everything we do to the Cairo state is undone by end(), so that a cached
+	// context starts off in the same state as a new one.
+	cairo_save(cc);
+#ifdef FXDCCAIRO_INSTRUMENT
+	if (!opstats)
+		FXCALLOC(&opstats, FXCairoOpStats, 1);
+#endif
+	tlayout = NULL;
 	tsurf = NULL;
 	ssurf = NULL;
 	ksurf = NULL;
@@ -125,9 +568,13 @@ void FXDCCairo::begin(FXDrawable *drawable)
 	sharp_offset = FALSE;
 	cr_fillstyle = FILL_SOLID;
 	cr_tile = NULL;
-	pfd = NULL;
-	layout = pango_cairo_create_layout(cc);
+	cr_stipple = NULL;
+	cr_pattern = STIPPLE_NONE;
 	cr_mask = FALSE;
+	cr_maskclip = FALSE;
+	cr_clips = NULL;
+	cr_nclips = 0;
+	transformChanged();
 	
 	// Make default compatible with DCWindow...
 	cairo_set_fill_rule(cc, CAIRO_FILL_RULE_EVEN_ODD);
@@ -144,87 +591,244 @@ void FXDCCairo::begin(FXDrawable *drawable)
 void FXDCCairo::end()
 {
 	surface=NULL;
-	cairo_destroy(cc);
+	cairo_new_path(cc);
+	if (cr_maskclip)
+		cairo_restore(cc);
+	freeClips();
+	cr_mask = FALSE;
+	cr_maskclip = FALSE;
+	cairo_restore(cc);
+	if (centry) {
+		centry->busy = FALSE;
+		if (centry->drawable)
+			cairo_surface_flush(csurf);
+		else
+			fxFreeSurfaceEntry(centry);	// Released while we were using it
+		centry = NULL;
+	}
+	else {
+		cairo_destroy(cc);
+		cairo_surface_flush(csurf);
+		cairo_surface_destroy(csurf);
+		g_object_unref(layout);
+	}
 	cc = NULL;
-	cairo_surface_destroy(csurf);
 	csurf = NULL;
+	if (cr_ownpfd)
+		pango_font_description_free(pfd);
+	pfd = NULL;
+	cr_ownpfd = FALSE;
+	cr_font = NULL;
+	layout = NULL;
+	tlayout = NULL;
 	if (tsurf) cairo_surface_destroy(tsurf);
 	tsurf = NULL;
 	if (ssurf) cairo_surface_destroy(ssurf);
 	ssurf = NULL;
 	if (ksurf) cairo_surface_destroy(ksurf);
 	ksurf = NULL;
-	if (pfd) pango_font_description_free(pfd);
-	pfd = NULL;
-	g_object_unref(layout);
-	layout = NULL;	
 }
 
 
 // Read back pixel
 FXColor FXDCCairo::readPixel(FXint x,FXint y)
 {
+	INSTRUMENT(READ_PIXEL);
 	// Cairo does not readily support reading back pixel data.  So, just transform
 	// co-ordinates back to device space and call the base class.
 	// Note that cairo device coordinate (0.5, 0.5) is the "pixel centre" so floor()
 	// gives the appropriate nearest pixel in integer coordinates.
 	double xx = x;
 	double yy = y;
-	cairo_user_to_device(cc, &xx, &yy);
+	transformFlags();
+	cairo_matrix_transform_point(&cr_ctm, &xx, &yy);
 	return FXDCWindow::readPixel((FXint)floor(xx), (FXint)floor(yy));
 }
 
 
+/*
+	Transformation cache.
+	
+	Several primitives need to know whether the transformation is the identity
+	(line sharpening, point squares, cached text layouts, server copies) or how big
+	a device pixel is in user space (zero width lines, points).  Rather than ask
+	Cairo on each call, the matrix and what follows from it are kept in cr_ctm,
+	cr_xform, cr_pixw and cr_pixh, and worked out again only after
+	transformChanged().  The DC itself only changes the transformation inside
+	cairo_save() / cairo_restore(), apart from the half pixel offset of
+	sharpOffset(), which adjusts cr_ctm as it goes.  A subclass which changes the
+	transformation must call transformChanged().
+*/
+
+// Copy the transformation, and find the size of a device pixel under it
+void FXDCCairo::updateTransform()
+{
+	INSTRUMENT(UPDATE_TRANSFORM);
+	cairo_get_matrix(cc, &cr_ctm);
+	cr_xform = XFORM_KNOWN;
+	cr_pixw = 1.;
+	cr_pixh = 1.;
+	if (cr_ctm.xy == 0. && cr_ctm.yx == 0.) {
+		cr_xform |= XFORM_AXIS;
+		if (cr_ctm.xx == 1. && cr_ctm.yy == 1.)
+			cr_xform |= XFORM_UNIT;
+	}
+	if (!(cr_xform & XFORM_UNIT))
+		cairo_device_to_user_distance(cc, &cr_pixw, &cr_pixh);
+}
+
+
+// Return TRUE if user space pixels are device pixels
+FXbool FXDCCairo::pixelAligned()
+{
+	return (transformFlags() & XFORM_UNIT) &&
+	       cr_ctm.x0 == floor(cr_ctm.x0) && cr_ctm.y0 == floor(cr_ctm.y0);
+}
+
+
+// Restore Cairo fill rule after temporary change
+void FXDCCairo::resetFillRule()
+{
+	cairo_set_fill_rule(cc, rule == RULE_WINDING ? CAIRO_FILL_RULE_WINDING : CAIRO_FILL_RULE_EVEN_ODD);
+}
+
+
+// Return TRUE if painting twice over the same pixel gives the same as once,
+// for a stroke or a fill
+FXbool FXDCCairo::opaqueSource(FXbool stroke)
+{
+	if (fill != FILL_SOLID || FXALPHAVAL(fg) != 255)
+		return FALSE;
+	return !stroke || style != LINE_DOUBLE_DASH || FXALPHAVAL(bg) == 255;
+}
+
+
+// Find square to be filled for a point at x,y: (x-ox, y-oy, xx, yy).
+// Returns TRUE if the square is exactly one device pixel.
+FXbool FXDCCairo::pointSquare(double & ox, double & oy, double & xx, double & yy)
+{
+	// Single pixels are not a good fit for Cairo.  Replace with an appropriately centred
+	// single pixel "square" in device space.  With an identity transform and line
+	// sharpening on, this is the Xlib pixel i.e. the square to the right and below
+	// x,y, just as sharpened lines are offset by half a pixel.  Otherwise it is a
+	// device pixel sized square centred on x,y.
+	if (do_sharpen && pixelAligned()) {
+		ox = oy = 0.;
+		xx = yy = 1.;
+		return TRUE;
+	}
+	transformFlags();
+	xx = cr_pixw;
+	yy = cr_pixh;
+	ox = xx/2;
+	oy = yy/2;
+	return FALSE;
+}
+
+
 // Draw point
 void FXDCCairo::drawPoint(FXint x,FXint y)
 {
-	// Single pixels are not a good fit for Cairo.  Replace with an appropriately centred
-	// single pixel "square" in device space.  This function should not really be used
-	// for non-identity transforms.
+	INSTRUMENT(DRAW_POINT);
+	// This function should not really be used for non-identity transforms.
 	if(!surface) {
 		fxerror("FXDCCairo::drawPoint: DC not connected to drawable.\n");
 	}
-	double xx = 1.;
-	double yy = 1.;
-	cairo_device_to_user_distance(cc, &xx, &yy);
-	cairo_rectangle(cc, x-xx/2, y-yy/2, xx, yy);
+	double ox, oy, xx, yy;
+	pointSquare(ox, oy, xx, yy);
+	cairo_rectangle(cc, x-ox, y-oy, xx, yy);
 	paint(FALSE, TRUE);
 }
 
 
+// Fill point squares, all at once if that gives the same result
+static FXbool fxRectanglesOverlap(const FXRectangle* r, FXuint n);
+
+// Return TRUE if any point occurs more than once
+static FXbool fxPointsRepeated(const FXPoint* points, FXuint n, FXbool relative)
+{
+	FXRectangle local[64];
+	FXRectangle * r = local;
+	if (n > ARRAYNUMBER(local))
+		FXMALLOC(&r, FXRectangle, n);
+	for (FXuint i = 0; i < n; ++i) {
+		r[i].x = points[i].x;
+		r[i].y = points[i].y;
+		if (relative && i) {
+			r[i].x += r[i-1].x;
+			r[i].y += r[i-1].y;
+		}
+		r[i].w = r[i].h = 1;
+	}
+	FXbool repeated = fxRectanglesOverlap(r, n);
+	if (r != local)
+		FXFREE(&r);
+	return repeated;
+}
+
+void FXDCCairo::fillPoints(const FXPoint* points,FXuint npoints,FXbool relative)
+{
+	// A single fill is the same as painting each square in turn if the source is
+	// opaque, or if the squares do not overlap.  Pixel squares overlap only for
+	// repeated points; if the squares are not pixel aligned, neighbouring points
+	// share partly covered pixels, so those are always painted one at a time.
+	double ox, oy, xx, yy;
+	FXbool aligned = pointSquare(ox, oy, xx, yy);
+	FXbool batch = opaqueSource(FALSE) || (aligned && !fxPointsRepeated(points, npoints, relative));
+	short x = 0;
+	short y = 0;
+	if (batch)
+		cairo_set_fill_rule(cc, CAIRO_FILL_RULE_WINDING);
+	for (FXuint n = 0; n < npoints; ++n) {
+		if (relative && n) {
+			x += points[n].x;
+			y += points[n].y;
+		}
+		else {
+			x = points[n].x;
+			y = points[n].y;
+		}
+		cairo_rectangle(cc, x-ox, y-oy, xx, yy);
+		if (!batch)
+			paint(FALSE, TRUE);
+	}
+	if (batch) {
+		paint(FALSE, TRUE);
+		resetFillRule();
+	}
+}
+
+
 // Draw points
 void FXDCCairo::drawPoints(const FXPoint* points,FXuint npoints)
 {
+	INSTRUMENT(DRAW_POINTS);
 	if(!surface) {
 		fxerror("FXDCCairo::drawPoints: DC not connected to drawable.\n");
 	}
-	for (FXuint n = 0; n < npoints; ++n)
-		drawPoint(points[n].x, points[n].y);
+	if (!npoints)
+		return;
+	fillPoints(points, npoints, FALSE);
 }
 
 
 // Draw points relative
 void FXDCCairo::drawPointsRel(const FXPoint* points,FXuint npoints)
 {
+	INSTRUMENT(DRAW_POINTS);
 	if(!surface) {
 		fxerror("FXDCCairo::drawPointsRel: DC not connected to drawable.\n");
 	}
 	if (!npoints)
 		return;
-	short x = points[0].x;
-	short y = points[0].y;
-	drawPoint(x, y);
-	for (FXuint n = 1; n < npoints; ++n) {
-		x += points[n].x;
-		y += points[n].y;
-		drawPoint(x, y);
-	}
+	fillPoints(points, npoints, TRUE);
 }
 
 
 // Draw line
 void FXDCCairo::drawLine(FXint x1,FXint y1,FXint x2,FXint y2)
 {
+	INSTRUMENT(DRAW_LINE);
 	if(!surface) {
 		fxerror("FXDCCairo::drawLine: DC not connected to drawable.\n");
 	}
@@ -258,6 +862,7 @@ FXbool FXDCCairo::pathLines(const FXPoint* points,FXuint npoints,FXbool for_stro
 // Draw lines
 void FXDCCairo::drawLines(const FXPoint* points,FXuint npoints)
 {
+	INSTRUMENT(DRAW_LINES);
 	pathLines(points, npoints);
 	paint();
 }
@@ -296,6 +901,7 @@ FXbool FXDCCairo::pathLinesRel(const FXPoint* points,FXuint npoints,FXbool for_s
 // Draw lines relative
 void FXDCCairo::drawLinesRel(const FXPoint* points,FXuint npoints)
 {
+	INSTRUMENT(DRAW_LINES);
 	pathLinesRel(points, npoints);
 	paint();
 }
@@ -304,6 +910,7 @@ void FXDCCairo::drawLinesRel(const FXPoint* points,FXuint npoints)
 // Draw line segments
 void FXDCCairo::drawLineSegments(const FXSegment* segments,FXuint nsegments)
 {
+	INSTRUMENT(DRAW_LINE_SEGMENTS);
 	if(!surface) {
 		fxerror("FXDCCairo::drawLineSegments: DC not connected to drawable.\n");
 	}
@@ -322,6 +929,7 @@ void FXDCCairo::drawLineSegments(const FXSegment* segments,FXuint nsegments)
 // Draw rectangle
 void FXDCCairo::drawRectangle(FXint x,FXint y,FXint w,FXint h)
 {
+	INSTRUMENT(DRAW_RECTANGLE);
 	if(!surface) {
 		fxerror("FXDCCairo::drawRectangle: DC not connected to drawable.\n");
 	}
@@ -335,6 +943,7 @@ void FXDCCairo::drawRectangle(FXint x,FXint y,FXint w,FXint h)
 // Draw rectangles
 void FXDCCairo::drawRectangles(const FXRectangle* rectangles,FXuint nrectangles)
 {
+	INSTRUMENT(DRAW_RECTANGLES);
 	if(!surface) {
 		fxerror("FXDCCairo::drawRectangles: DC not connected to drawable.\n");
 	}
@@ -390,10 +999,60 @@ void FXDCCairo::pathRoundRectangle(FXint x,FXint y,FXint w,FXint h,FXint ew,FXin
 
 void FXDCCairo::drawRoundRectangle(FXint x,FXint y,FXint w,FXint h,FXint ew,FXint eh)
 {
+	INSTRUMENT(DRAW_ROUND_RECTANGLE);
 	pathRoundRectangle(x, y, w, h, ew, eh, 0.6);
 	paint();
 }
 
+// Largest angle (radians, at most 90 degrees) of the Bezier segments for an arc
+// whose major axis is r device units, to stay within tolerance.  A segment of
+// angle t deviates from the circle by about r*(2/27)*sin(t/4)^6/cos(t/4)^2.
+static double fxArcSegmentAngle(double r, double tolerance)
+{
+	for (FXint m = 1; m < 1024; ++m) {
+		double t = (DTOR*90.)/m;
+		double s = sin(t/4.);
+		double c = cos(t/4.);
+		if (r*(2./27.)*s*s*s*s*s*s/(c*c) <= tolerance)
+			return t;
+	}
+	return (DTOR*90.)/1024;
+}
+
+
+// Add elliptical arc centred on cx,cy with radii rx,ry, from angle a1 to a2 (radians,
+// in Cairo's direction) as Bezier curves, without changing the transformation.  As
+// cairo_arc() does, the number of segments depends on Cairo's tolerance and on the
+// size of the arc in device space: the larger radius, scaled by the major axis of
+// the transformation.
+static void fxPathEllipseArc(cairo_t * cc, double cx, double cy, double rx, double ry, double a1, double a2)
+{
+	cairo_matrix_t m;
+	cairo_get_matrix(cc, &m);
+	double lx = m.xx*m.xx + m.yx*m.yx;	// Squared lengths of the unit vectors
+	double ly = m.xy*m.xy + m.yy*m.yy;
+	double major = FXMAX(fabs(rx), fabs(ry)) * sqrt(0.5*(lx + ly) + hypot(0.5*(lx - ly), m.xx*m.xy + m.yx*m.yy));
+	double t = fxArcSegmentAngle(major, cairo_get_tolerance(cc));
+	FXint n = (FXint)ceil(fabs(a2 - a1)/t - 1e-9);
+	if (n < 1)
+		n = 1;
+	double d = (a2 - a1)/n;
+	double k = 4./3.*tan(d/4.);
+	double c0 = cos(a1);
+	double s0 = sin(a1);
+	cairo_move_to(cc, cx + rx*c0, cy + ry*s0);
+	for (FXint i = 1; i <= n; ++i) {
+		double a = i == n ? a2 : a1 + i*d;
+		double c1 = cos(a);
+		double s1 = sin(a);
+		cairo_curve_to(cc, cx + rx*(c0 - k*s0), cy + ry*(s0 + k*c0),
+		                   cx + rx*(c1 + k*s1), cy + ry*(s1 - k*c1),
+		                   cx + rx*c1, cy + ry*s1);
+		c0 = c1;
+		s0 = s1;
+	}
+}
+
 // Draw arc path only, Xlib style
 void FXDCCairo::pathArc(FXint x,FXint y,FXint w,FXint h,FXint ang1,FXint ang2, FXbool pie, FXbool for_stroke)
 {
@@ -402,46 +1061,83 @@ void FXDCCairo::pathArc(FXint x,FXint y,FXint w,FXint h,FXint ang1,FXint ang2, F
 	}
 	FXCLAMP(-360*64, ang2, 360*64);
 	if (for_stroke) sharpOffset(TRUE);
-	cairo_save(cc);
-	cairo_translate(cc, x + w*0.5, y + h * 0.5);
-	cairo_scale(cc, w*0.5, h*0.5);
-	// Now in centre of 2x2 square.
-	cairo_new_sub_path(cc);
-	if (ang2 < 0)
-		cairo_arc(cc, 0., 0., 1., DTOR*(ang1/-64.), DTOR*((ang1+ang2)/-64.));
-	else
-		cairo_arc_negative(cc, 0., 0., 1., DTOR*(ang1/-64.), DTOR*((ang1+ang2)/-64.));
+	double cx = x + w*0.5;
+	double cy = y + h*0.5;
+	double a1 = DTOR*(ang1/-64.);
+	double a2 = DTOR*((ang1+ang2)/-64.);
+	if (!for_stroke && a2 < a1) {
+		// The filled shape is the same either way round.  Always going the same
+		// way means that overlapping shapes in one path add up under the winding
+		// rule, instead of cancelling out (see fillArcs()).
+		double t = a1;
+		a1 = a2;
+		a2 = t;
+	}
+	fxPathEllipseArc(cc, cx, cy, w*0.5, h*0.5, a1, a2);
 	if (ang2 == -360*64 || ang2 == 360*64)
 		cairo_close_path(cc);
 	else if (pie)
-		cairo_line_to(cc, 0., 0.);
-	cairo_restore(cc);
+		cairo_line_to(cc, cx, cy);
 	if (for_stroke) sharpOffset(FALSE);
 }
 
 // Draw arc
 void FXDCCairo::drawArc(FXint x,FXint y,FXint w,FXint h,FXint ang1,FXint ang2)
 {
+	INSTRUMENT(DRAW_ARC);
 	pathArc(x, y, w, h, ang1, ang2, FALSE, TRUE);
 	paint();
 }
 
 
+// Return TRUE if the bounding boxes of any two arcs, grown by g on each side, overlap
+static FXbool fxArcsOverlap(const FXArc* arcs, FXuint n, FXint g)
+{
+	FXRectangle local[64];
+	FXRectangle * r = local;
+	if (n > ARRAYNUMBER(local))
+		FXMALLOC(&r, FXRectangle, n);
+	for (FXuint i = 0; i < n; ++i) {
+		r[i].x = arcs[i].x - g;
+		r[i].y = arcs[i].y - g;
+		r[i].w = arcs[i].w + 2*g;
+		r[i].h = arcs[i].h + 2*g;
+	}
+	FXbool overlap = fxRectanglesOverlap(r, n);
+	if (r != local)
+		FXFREE(&r);
+	return overlap;
+}
+
 
 // Draw arcs
 void FXDCCairo::drawArcs(const FXArc* arcs,FXuint narcs)
 {
+	INSTRUMENT(DRAW_ARCS);
 	if(!surface) {
 		fxerror("FXDCCairo::drawArcs: DC not connected to drawable.\n");
 	}
-	for (FXuint n = 0; n < narcs; ++n)
-		drawArc(arcs[n].x, arcs[n].y, arcs[n].w, arcs[n].h, arcs[n].a, arcs[n].b);
+	if (narcs < 1)
+		return;
+	// As for fillRectangles(), one stroke of all the arcs is the same as stroking
+	// each in turn unless they are translucent and overlap.
+	if (opaqueSource(TRUE) || !fxArcsOverlap(arcs, narcs, width/2 + 1)) {
+		for (FXuint n = 0; n < narcs; ++n)
+			pathArc(arcs[n].x, arcs[n].y, arcs[n].w, arcs[n].h, arcs[n].a, arcs[n].b, FALSE, TRUE);
+		paint();
+		return;
+	}
+	for (FXuint n = 0; n < narcs; ++n) {
+		pathArc(arcs[n].x, arcs[n].y, arcs[n].w, arcs[n].h, arcs[n].a, arcs[n].b, FALSE, TRUE);
+		paint();
+	}
 }
 
 
 // Draw ellipse
 void FXDCCairo::drawEllipse(FXint x,FXint y,FXint w,FXint h)
 {
+	INSTRUMENT(DRAW_ELLIPSE);
 	drawArc(x,y,w,h,0,23040);
 }
 
@@ -449,6 +1145,7 @@ void FXDCCairo::drawEllipse(FXint x,FXint y,FXint w,FXint h)
 // Fill rectangle
 void FXDCCairo::fillRectangle(FXint x,FXint y,FXint w,FXint h)
 {
+	INSTRUMENT(FILL_RECTANGLE);
 	if(!surface) {
 		fxerror("FXDCCairo::fillRectangle: DC not connected to drawable.\n");
 	}
@@ -457,16 +1154,72 @@ void FXDCCairo::fillRectangle(FXint x,FXint y,FXint w,FXint h)
 }
 
 
+// Return TRUE if any two of the rectangles overlap
+static FXbool fxRectanglesOverlap(const FXRectangle* r, FXuint n)
+{
+	if (n <= 16) {
+		for (FXuint i = 0; i < n; ++i)
+			for (FXuint j = i+1; j < n; ++j)
+				if (r[i].x < r[j].x+r[j].w && r[j].x < r[i].x+r[i].w &&
+				    r[i].y < r[j].y+r[j].h && r[j].y < r[i].y+r[i].h)
+					return TRUE;
+		return FALSE;
+	}
+	// The area of the union (found by pixman's region code, which sorts the
+	// rectangles into bands) is less than the sum of the areas if and only if
+	// some rectangles overlap.
+	cairo_rectangle_int_t * cr;
+	FXMALLOC(&cr, cairo_rectangle_int_t, n);
+	FXdouble sum = 0.;
+	FXuint m = 0;
+	for (FXuint i = 0; i < n; ++i) {
+		if (r[i].w <= 0 || r[i].h <= 0)
+			continue;
+		cr[m].x = r[i].x;
+		cr[m].y = r[i].y;
+		cr[m].width = r[i].w;
+		cr[m].height = r[i].h;
+		sum += (FXdouble)r[i].w*r[i].h;
+		++m;
+	}
+	cairo_region_t * rgn = cairo_region_create_rectangles(cr, m);
+	FXdouble area = 0.;
+	FXint nr = cairo_region_num_rectangles(rgn);
+	for (FXint i = 0; i < nr; ++i) {
+		cairo_rectangle_int_t b;
+		cairo_region_get_rectangle(rgn, i, &b);
+		area += (FXdouble)b.width*b.height;
+	}
+	cairo_region_destroy(rgn);
+	FXFREE(&cr);
+	return area < sum;
+}
+
+
 // Fill rectangles
 void FXDCCairo::fillRectangles(const FXRectangle* rectangles,FXuint nrectangles)
 {
+	INSTRUMENT(FILL_RECTANGLES);
 	if(!surface) {
 		fxerror("FXDCCairo::fillRectangles: DC not connected to drawable.\n");
 	}
 	if (nrectangles < 1)
 		return;
-	// The Xlib call is not the same as filling all the rectangles at once, so we are slightly
-	// less efficient.
+	// The Xlib call is not the same as filling all the rectangles at once, since
+	// each one is painted in turn.  A single fill (with the non-zero winding rule,
+	// so overlaps are not holes) gives the same result if the source is opaque, or
+	// if no two rectangles overlap.  Only translucent overlapping rectangles need
+	// to be painted one at a time.
+	if (opaqueSource(FALSE) || !fxRectanglesOverlap(rectangles, nrectangles)) {
+		cairo_set_fill_rule(cc, CAIRO_FILL_RULE_WINDING);
+		for (FXuint n = 0; n < nrectangles; ++n) {
+			if (rectangles[n].w > 0 && rectangles[n].h > 0)
+				cairo_rectangle(cc, rectangles[n].x, rectangles[n].y, rectangles[n].w, rectangles[n].h);
+		}
+		paint(FALSE, TRUE);
+		resetFillRule();
+		return;
+	}
 	for (FXuint n = 0; n < nrectangles; ++n) {
 		cairo_rectangle(cc, rectangles[n].x, rectangles[n].y, rectangles[n].w, rectangles[n].h);
 		paint(FALSE, TRUE);
@@ -477,6 +1230,7 @@ void FXDCCairo::fillRectangles(const FXRectangle* rectangles,FXuint nrectangles)
 // Fill rounded rectangle
 void FXDCCairo::fillRoundRectangle(FXint x,FXint y,FXint w,FXint h,FXint ew,FXint eh)
 {
+	INSTRUMENT(FILL_ROUND_RECTANGLE);
 	pathRoundRectangle(x, y, w, h, ew, eh, 0.6);
 	paint(FALSE, TRUE);
 }
@@ -485,6 +1239,7 @@ void FXDCCairo::fillRoundRectangle(FXint x,FXint y,FXint w,FXint h,FXint ew,FXin
 // Fill chord
 void FXDCCairo::fillChord(FXint x,FXint y,FXint w,FXint h,FXint ang1,FXint ang2)
 {
+	INSTRUMENT(FILL_CHORD);
 	pathArc(x, y, w, h, ang1, ang2, FALSE, FALSE);
 	paint(FALSE, TRUE);
 }
@@ -493,14 +1248,15 @@ void FXDCCairo::fillChord(FXint x,FXint y,FXint w,FXint h,FXint ang1,FXint ang2)
 // Fill chords
 void FXDCCairo::fillChords(const FXArc* chords,FXuint nchords)
 {
-	for (FXuint n = 0; n < nchords; ++n)
-		fillChord(chords[n].x, chords[n].y, chords[n].w, chords[n].h, chords[n].a, chords[n].b);
+	INSTRUMENT(FILL_CHORDS);
+	paintArcs(chords, nchords, FALSE);
 }
 
 
 // Fill arc
 void FXDCCairo::fillArc(FXint x,FXint y,FXint w,FXint h,FXint ang1,FXint ang2)
 {
+	INSTRUMENT(FILL_ARC);
 	pathArc(x, y, w, h, ang1, ang2, TRUE, FALSE);
 	paint(FALSE, TRUE);
 }
@@ -509,14 +1265,40 @@ void FXDCCairo::fillArc(FXint x,FXint y,FXint w,FXint h,FXint ang1,FXint ang2)
 // Fill arcs
 void FXDCCairo::fillArcs(const FXArc* arcs,FXuint narcs)
 {
-	for (FXuint n = 0; n < narcs; ++n)
-		fillArc(arcs[n].x, arcs[n].y, arcs[n].w, arcs[n].h, arcs[n].a, arcs[n].b);
+	INSTRUMENT(FILL_ARCS);
+	paintArcs(arcs, narcs, TRUE);
+}
+
+
+// Fill pies or chords.  As for fillRectangles(), they are filled at once (with
+// the winding rule, and all in the same direction, so overlaps are not holes)
+// unless they are translucent and overlap.
+void FXDCCairo::paintArcs(const FXArc* arcs,FXuint narcs,FXbool pie)
+{
+	if(!surface) {
+		fxerror("FXDCCairo::paintArcs: DC not connected to drawable.\n");
+	}
+	if (narcs < 1)
+		return;
+	if (opaqueSource(FALSE) || !fxArcsOverlap(arcs, narcs, 0)) {
+		cairo_set_fill_rule(cc, CAIRO_FILL_RULE_WINDING);
+		for (FXuint n = 0; n < narcs; ++n)
+			pathArc(arcs[n].x, arcs[n].y, arcs[n].w, arcs[n].h, arcs[n].a, arcs[n].b, pie, FALSE);
+		paint(FALSE, TRUE);
+		resetFillRule();
+		return;
+	}
+	for (FXuint n = 0; n < narcs; ++n) {
+		pathArc(arcs[n].x, arcs[n].y, arcs[n].w, arcs[n].h, arcs[n].a, arcs[n].b, pie, FALSE);
+		paint(FALSE, TRUE);
+	}
 }
 
 
 // Fill ellipse
 void FXDCCairo::fillEllipse(FXint x,FXint y,FXint w,FXint h)
 {
+	INSTRUMENT(FILL_ELLIPSE);
 	pathArc(x, y, w, h, 0, 23040, FALSE, FALSE);
 	paint(FALSE, TRUE);
 }
@@ -525,6 +1307,7 @@ void FXDCCairo::fillEllipse(FXint x,FXint y,FXint w,FXint h)
 // Fill polygon
 void FXDCCairo::fillPolygon(const FXPoint* points,FXuint npoints)
 {
+	INSTRUMENT(FILL_POLYGON);
 	fillComplexPolygon(points, npoints);
 }
 
@@ -532,6 +1315,7 @@ void FXDCCairo::fillPolygon(const FXPoint* points,FXuint npoints)
 // Fill concave polygon
 void FXDCCairo::fillConcavePolygon(const FXPoint* points,FXuint npoints)
 {
+	INSTRUMENT(FILL_POLYGON);
 	fillComplexPolygon(points, npoints);
 }
 
@@ -539,6 +1323,7 @@ void FXDCCairo::fillConcavePolygon(const FXPoint* points,FXuint npoints)
 // Fill complex polygon
 void FXDCCairo::fillComplexPolygon(const FXPoint* points,FXuint npoints)
 {
+	INSTRUMENT(FILL_POLYGON);
 	if (pathLines(points, npoints, FALSE))
 		cairo_close_path(cc);
 	paint(FALSE, TRUE);
@@ -548,6 +1333,7 @@ void FXDCCairo::fillComplexPolygon(const FXPoint* points,FXuint npoints)
 // Fill polygon relative
 void FXDCCairo::fillPolygonRel(const FXPoint* points,FXuint npoints)
 {
+	INSTRUMENT(FILL_POLYGON);
 	fillComplexPolygonRel(points, npoints);
 }
 
@@ -555,6 +1341,7 @@ void FXDCCairo::fillPolygonRel(const FXPoint* points,FXuint npoints)
 // Fill concave polygon relative
 void FXDCCairo::fillConcavePolygonRel(const FXPoint* points,FXuint npoints)
 {
+	INSTRUMENT(FILL_POLYGON);
 	fillComplexPolygonRel(points, npoints);
 }
 
@@ -562,12 +1349,65 @@ void FXDCCairo::fillConcavePolygonRel(const FXPoint* points,FXuint npoints)
 // Fill complex polygon relative
 void FXDCCairo::fillComplexPolygonRel(const FXPoint* points,FXuint npoints)
 {
+	INSTRUMENT(FILL_POLYGON);
 	if (pathLinesRel(points, npoints, FALSE))
 		cairo_close_path(cc);
 	paint(FALSE, TRUE);
 }
 
 
+/*
+	Font cache.
+	
+	Pango font descriptions are made from FXFont attributes once, and kept in a
+	process-wide cache keyed by the FXFont and its attributes, so a new DC, or
+	switching between fonts while painting, only costs a lookup.  The DC does
+	not own its description.  The resolved PangoFont and its metrics are kept
+	with the description, for measuring text without laying it out.
+*/
+
+static FXCairoFontCache fontCache;
+
+
+// Key for font: the object and the attributes its description depends on.
+// The family name is kept in family.
+static FXCairoFontCache::Key fontKey(const FXFont * fnt, FXString & family)
+{
+	family = fnt->getFamily();
+	FXCairoFontCache::Key key = { fnt, family.text(), fnt->getSize(),
+		fnt->getWeight(), fnt->getSlant(), fnt->getSetWidth() };
+	return key;
+}
+
+
+// Release all cached font descriptions
+void FXDCCairo::flushFontCache()
+{
+	fontCache.clear();
+}
+
+
+// Drop cached description of font
+void FXDCCairo::invalidateFont(const FXFont * font)
+{
+	fontCache.invalidate(font);
+}
+
+
+// Get font cache statistics
+void FXDCCairo::getFontCacheStats(FXCairoCacheStats & stats)
+{
+	stats = fontCache.getStats();
+}
+
+
+// Reset font cache counters
+void FXDCCairo::resetFontCacheStats()
+{
+	fontCache.resetStats();
+}
+
+
 // Set text font
 void FXDCCairo::setFont(FXFont *fnt)
 {
@@ -577,31 +1417,20 @@ void FXDCCairo::setFont(FXFont *fnt)
 	if(!fnt) {
 		fxerror("FXDCCairo::setFont: illegal or NULL font specified.\n");
 	}
-	//pfd = pango_font_description_from_string (FONT);
-	if (fnt != font) {
-		if (!pfd)
-			pfd = pango_font_description_new();
-		pango_font_description_set_family(pfd, fnt->getFamily().text());
-		pango_font_description_set_style(pfd,
-			fnt->getSlant() == FXFont::Italic ? PANGO_STYLE_ITALIC :
-			fnt->getSlant() == FXFont::Oblique ? PANGO_STYLE_OBLIQUE :
-			PANGO_STYLE_NORMAL);
-		pango_font_description_set_weight(pfd,
-			(PangoWeight)(fnt->getWeight() * 10));
-		pango_font_description_set_stretch(pfd,
-			fnt->getSetWidth() == FXFont::UltraCondensed ? PANGO_STRETCH_ULTRA_CONDENSED :
-			fnt->getSetWidth() == FXFont::ExtraCondensed ? PANGO_STRETCH_EXTRA_CONDENSED :
-			fnt->getSetWidth() == FXFont::Condensed ? PANGO_STRETCH_CONDENSED :
-			fnt->getSetWidth() == FXFont::SemiCondensed ? PANGO_STRETCH_SEMI_CONDENSED :
-			fnt->getSetWidth() == FXFont::SemiExpanded ? PANGO_STRETCH_SEMI_EXPANDED :
-			fnt->getSetWidth() == FXFont::Expanded ? PANGO_STRETCH_EXPANDED :
-			fnt->getSetWidth() == FXFont::ExtraExpanded ? PANGO_STRETCH_EXTRA_EXPANDED :
-			fnt->getSetWidth() == FXFont::UltraExpanded ? PANGO_STRETCH_ULTRA_EXPANDED :
-			PANGO_STRETCH_NORMAL);
-		pango_font_description_set_size(pfd,
-			fnt->getSize()*PANGO_SCALE/10);
-		font = fnt;
+	// Only look up the description when the font changes, as FXDCWindow only
+	// changes the GC then.
+	if (fnt != cr_font) {
+		FXString family;
+		if (cr_ownpfd)
+			pango_font_description_free(pfd);
+		cr_ownpfd = !fxSharedCaches();
+		if (cr_ownpfd)
+			pfd = FXCairoFontCache::describe(fontKey(fnt, family));
+		else
+			pfd = fontCache.lookup(fontKey(fnt, family));
+		cr_font = fnt;
 	}
+	font = fnt;
 }
 
 
@@ -609,20 +1438,84 @@ void FXDCCairo::setFont(FXFont *fnt)
 
 	We use Pango for text layout.  FXFont objects are used only to specify the
 	face, size etc.
+	
+	Shaping text is expensive, and most text (labels, axis ticks, table cells) is
+	the same every time it is drawn, so layouts are cached by font and text.  The
+	cached layouts share one PangoContext, which Pango updates from the Cairo
+	context when the layout is shown.  A rotated font or a scaling transform
+	changes the context (and would make every cached layout be reshaped in turn),
+	so that text is laid out on the DC's own layout instead.
 
 */
 
+static FXCairoLayoutCache layoutCache;
+
+
+// Release all cached layouts
+void FXDCCairo::flushLayoutCache()
+{
+	layoutCache.clear();
+}
+
+
+// Set layout cache memory budget
+void FXDCCairo::setLayoutCacheBudget(FXuval bytes)
+{
+	layoutCache.setBudget(bytes);
+}
+
+
+// Get layout cache memory budget
+FXuval FXDCCairo::getLayoutCacheBudget()
+{
+	return layoutCache.getBudget();
+}
+
+
+// Get layout cache statistics
+void FXDCCairo::getLayoutCacheStats(FXCairoCacheStats & stats)
+{
+	stats = layoutCache.getStats();
+}
+
+
+// Reset layout cache counters
+void FXDCCairo::resetLayoutCacheStats()
+{
+	layoutCache.resetStats();
+}
+
+
+// Find layout for text in the current font, leaving it in tlayout
+void FXDCCairo::setTextLayout(const FXchar* string, FXuint length)
+{
+	INSTRUMENT(TEXT_LAYOUT);
+	// FXDCWindow starts with the application's normal font without calling
+	// setFont(), so there may be no description yet
+	if (font != cr_font)
+		setFont(font);
+	if (!font->getAngle() && (transformFlags() & XFORM_UNIT) && !cr_ownpfd) {
+		FXCairoLayoutCache::Key key = { pfd, string, length };
+		tlayout = layoutCache.lookup(key);
+	}
+	else {
+		pango_layout_set_text(layout, string, length);
+		pango_layout_set_font_description(layout, pfd);
+		tlayout = layout;
+	}
+}
+
 // Draw string with base line starting at x, y
 void FXDCCairo::drawText(FXint x,FXint y,const FXchar* string,FXuint length)
 {
+	INSTRUMENT(DRAW_TEXT);
 	if(!surface) {
 		fxerror("FXDCCairo::drawText: DC not connected to drawable.\n");
 	}
 	if(!font) {
 		fxerror("FXDCCairo::drawText: no font selected.\n");
 	}
-	pango_layout_set_text(layout, string, length);
-	pango_layout_set_font_description (layout, pfd);
+	setTextLayout(string, length);
 	paintTextLayout(x, y, FALSE);
 }
 
@@ -630,14 +1523,14 @@ void FXDCCairo::drawText(FXint x,FXint y,const FXchar* string,FXuint length)
 // Draw text starting at x, y over filled background
 void FXDCCairo::drawImageText(FXint x,FXint y,const FXchar* string,FXuint length)
 {
+	INSTRUMENT(DRAW_IMAGE_TEXT);
 	if(!surface) {
 		fxerror("FXDCCairo::drawImageText: DC not connected to drawable.\n");
 	}
 	if(!font) {
 		fxerror("FXDCCairo::drawImageText: no font selected.\n");
 	}
-	pango_layout_set_text(layout, string, length);
-	pango_layout_set_font_description (layout, pfd);
+	setTextLayout(string, length);
 	paintTextLayout(x, y, TRUE);
 }
 
@@ -658,10 +1551,290 @@ void FXDCCairo::drawImageText(FXint x,FXint y,const FXString& string)
 }
 
 
+/*
+	Batched text.
+	
+	Tables and logs draw many short strings in one font.  drawTexts() sets the
+	source (and mask group) once, and shows each layout at its position with
+	cairo_move_to(), rather than saving, translating and restoring the Cairo
+	state for every string.  Layouts come from the layout cache as usual.
+	Rotated text is drawn one string at a time.
+*/
+
+// Draw strings with base lines starting at their x, y
+void FXDCCairo::drawTexts(const FXCairoText* texts,FXuint ntexts)
+{
+	INSTRUMENT(DRAW_TEXTS);
+	if(!surface) {
+		fxerror("FXDCCairo::drawTexts: DC not connected to drawable.\n");
+	}
+	if(!font) {
+		fxerror("FXDCCairo::drawTexts: no font selected.\n");
+	}
+	if (!ntexts)
+		return;
+	if (font->getAngle()) {
+		for (FXuint i = 0; i < ntexts; ++i) {
+			setTextLayout(texts[i].text, texts[i].length);
+			paintTextLayout(texts[i].x, texts[i].y, FALSE);
+		}
+		return;
+	}
+	cairo_new_path(cc);
+	if (cr_mask && !cr_maskclip)
+		pushMask();
+	setSource();
+	for (FXuint i = 0; i < ntexts; ++i) {
+		setTextLayout(texts[i].text, texts[i].length);
+		cairo_move_to(cc, texts[i].x, texts[i].y - pango_layout_get_baseline(tlayout)/PANGO_SCALE);
+		pango_cairo_update_layout(cc, tlayout);
+		pango_cairo_show_layout(cc, tlayout);
+	}
+	cairo_new_path(cc);
+	if (cr_mask && !cr_maskclip)
+		popMask();
+}
+
+
+/*
+	Text measurement.
+	
+	FXFont measures text with Xft or core fonts, which need not agree with what
+	Pango draws here, so layout code which sizes text with FXFont can be a few
+	pixels out.  These measure with the cached layout which drawText() will use
+	for the same font and text (unrotated and unscaled), so the text is shaped
+	once for both.  Sizes are in user space units, rounded up to whole units.
+	Font metrics come from the resolved font, which is kept in the font cache.
+*/
+
+// Logical extents of text in pfd, and its baseline, in Pango units.  Laid out
+// on l if given, else with the layout cache.
+static void fxTextExtents(PangoFontDescription * pfd, const FXchar* string, FXuint length,
+						PangoRectangle & logext, FXint & baseline, PangoLayout * l = NULL)
+{
+	if (l) {
+		pango_layout_set_text(l, string, length);
+		pango_layout_set_font_description(l, pfd);
+	}
+	else {
+		FXCairoLayoutCache::Key key = { pfd, string, length };
+		l = layoutCache.lookup(key);
+	}
+	pango_layout_get_extents(l, NULL, &logext);
+	baseline = pango_layout_get_baseline(l);
+}
+
+
+// Measure text in font
+void FXDCCairo::getTextExtents(const FXFont* font,const FXchar* string,FXuint length,
+				FXint& width,FXint& height,FXint& baseline)
+{
+	INSTRUMENT_STATIC(MEASURE_TEXT);
+	if(!font) {
+		fxerror("FXDCCairo::getTextExtents: NULL font specified.\n");
+	}
+	FXString family;
+	PangoRectangle logext;
+	FXint base;
+	fxTextExtents(fontCache.lookup(fontKey(font, family)), string, length, logext, base);
+	width = PANGO_PIXELS_CEIL(logext.width);
+	height = PANGO_PIXELS_CEIL(logext.height);
+	baseline = PANGO_PIXELS_CEIL(base);
+}
+
+
+// Width of text in font
+FXint FXDCCairo::getTextWidth(const FXFont* font,const FXchar* string,FXuint length)
+{
+	FXint w, h, b;
+	getTextExtents(font, string, length, w, h, b);
+	return w;
+}
+
+
+// Width of text in font
+FXint FXDCCairo::getTextWidth(const FXFont* font,const FXString& string)
+{
+	return getTextWidth(font, string.text(), string.length());
+}
+
+
+// Height of text in font
+FXint FXDCCairo::getTextHeight(const FXFont* font,const FXchar* string,FXuint length)
+{
+	FXint w, h, b;
+	getTextExtents(font, string, length, w, h, b);
+	return h;
+}
+
+
+// Height of text in font
+FXint FXDCCairo::getTextHeight(const FXFont* font,const FXString& string)
+{
+	return getTextHeight(font, string.text(), string.length());
+}
+
+
+// Ascent of font
+FXint FXDCCairo::getFontAscent(const FXFont* font)
+{
+	if(!font) {
+		fxerror("FXDCCairo::getFontAscent: NULL font specified.\n");
+	}
+	FXString family;
+	PangoFontMetrics * m = fontCache.getMetrics(fontKey(font, family));
+	return m ? PANGO_PIXELS_CEIL(pango_font_metrics_get_ascent(m)) : 0;
+}
+
+
+// Descent of font
+FXint FXDCCairo::getFontDescent(const FXFont* font)
+{
+	if(!font) {
+		fxerror("FXDCCairo::getFontDescent: NULL font specified.\n");
+	}
+	FXString family;
+	PangoFontMetrics * m = fontCache.getMetrics(fontKey(font, family));
+	return m ? PANGO_PIXELS_CEIL(pango_font_metrics_get_descent(m)) : 0;
+}
+
+
+// Height of font
+FXint FXDCCairo::getFontHeight(const FXFont* font)
+{
+	return getFontAscent(font) + getFontDescent(font);
+}
+
+
+// Measure text in the current font
+void FXDCCairo::getTextExtents(const FXchar* string,FXuint length,FXint& width,FXint& height,FXint& baseline) const
+{
+	INSTRUMENT(MEASURE_TEXT);
+	if(!font) {
+		fxerror("FXDCCairo::getTextExtents: no font selected.\n");
+	}
+	PangoRectangle logext;
+	FXint base;
+	FXString family;
+	if (fxSharedCaches()) {
+		PangoFontDescription * desc = font == cr_font ? pfd : fontCache.lookup(fontKey(font, family));
+		fxTextExtents(desc, string, length, logext, base);
+	}
+	else {
+		PangoFontDescription * desc = font == cr_font ? pfd : FXCairoFontCache::describe(fontKey(font, family));
+		fxTextExtents(desc, string, length, logext, base, layout);
+		if (desc != pfd)
+			pango_font_description_free(desc);
+	}
+	width = PANGO_PIXELS_CEIL(logext.width);
+	height = PANGO_PIXELS_CEIL(logext.height);
+	baseline = PANGO_PIXELS_CEIL(base);
+}
+
+
+// Width of text in the current font
+FXint FXDCCairo::getTextWidth(const FXchar* string,FXuint length) const
+{
+	FXint w, h, b;
+	getTextExtents(string, length, w, h, b);
+	return w;
+}
+
+
+// Width of text in the current font
+FXint FXDCCairo::getTextWidth(const FXString& string) const
+{
+	return getTextWidth(string.text(), string.length());
+}
+
+
+// Height of text in the current font
+FXint FXDCCairo::getTextHeight(const FXchar* string,FXuint length) const
+{
+	FXint w, h, b;
+	getTextExtents(string, length, w, h, b);
+	return h;
+}
+
+
+// Height of text in the current font
+FXint FXDCCairo::getTextHeight(const FXString& string) const
+{
+	return getTextHeight(string.text(), string.length());
+}
+
+
+/*
+	Copying areas.
+	
+	Scrolling copies most of a window onto itself, usually with nothing but an
+	integer translation in effect.  Rather than make an Xlib surface for the
+	source and composite it, we flush Cairo and use XCopyArea() with the GC of
+	FXDCWindow, clipped to the Cairo clip as a list of device rectangles.  This
+	only applies when drawing on an Xlib surface, from a drawable of the same
+	depth, with no clip mask and a clip which Cairo can give as rectangles.
+	Anything else (scaled, rotated, masked, or drawing on an image or recording)
+	takes the general path.
+*/
+
+// Copy area on the server.  Returns FALSE if the general path must be used.
+FXbool FXDCCairo::copyAreaServer(const FXDrawable* source,FXint sx,FXint sy,
+				FXint sw,FXint sh,FXint dx,FXint dy)
+{
+#ifndef WIN32
+	if (cr_mask || cairo_surface_get_type(csurf) != CAIRO_SURFACE_TYPE_XLIB ||
+	    source->getVisual()->getDepth() != visual->getDepth() ||
+	    (source->isMemberOf(FXMETACLASS(FXImage)) && isImagePremultiplied((const FXImage *)source)))
+		return FALSE;
+	if (!(transformFlags() & XFORM_UNIT))
+		return FALSE;
+	double ox = sharp_offset ? cr_ctm.x0 - 0.5 : cr_ctm.x0;
+	double oy = sharp_offset ? cr_ctm.y0 - 0.5 : cr_ctm.y0;
+	if (ox != floor(ox) || oy != floor(oy))
+		return FALSE;
+	cairo_rectangle_list_t * cl = cairo_copy_clip_rectangle_list(cc);
+	if (cl->status != CAIRO_STATUS_SUCCESS) {
+		cairo_rectangle_list_destroy(cl);
+		return FALSE;
+	}
+	XRectangle local[16];
+	XRectangle * xr = local;
+	if (cl->num_rectangles > (int)ARRAYNUMBER(local))
+		FXMALLOC(&xr, XRectangle, cl->num_rectangles);
+	for (int i = 0; i < cl->num_rectangles; ++i) {
+		// Clip rectangles are in user space
+		const cairo_rectangle_t & r = cl->rectangles[i];
+		xr[i].x = (short)floor(r.x + cr_ctm.x0 + 0.5);
+		xr[i].y = (short)floor(r.y + cr_ctm.y0 + 0.5);
+		xr[i].width = (unsigned short)floor(r.width + 0.5);
+		xr[i].height = (unsigned short)floor(r.height + 0.5);
+	}
+	FXint ddx = dx + (FXint)ox;
+	FXint ddy = dy + (FXint)oy;
+	if (cl->num_rectangles) {
+		Display * dpy = DISPLAY(getApp());
+		cairo_surface_flush(csurf);
+		XSetClipRectangles(dpy, (GC)ctx, 0, 0, xr, cl->num_rectangles, Unsorted);
+		XCopyArea(dpy, source->id(), cairo_xlib_surface_get_drawable(csurf), (GC)ctx,
+			sx, sy, sw, sh, ddx, ddy);
+		XSetClipMask(dpy, (GC)ctx, None);
+		cairo_surface_mark_dirty_rectangle(csurf, ddx, ddy, sw, sh);
+	}
+	if (xr != local)
+		FXFREE(&xr);
+	cairo_rectangle_list_destroy(cl);
+	return TRUE;
+#else
+	return FALSE;
+#endif
+}
+
+
 // Draw area
 void FXDCCairo::drawArea(const FXDrawable* source,FXint sx,FXint sy,
 				FXint sw,FXint sh,FXint dx,FXint dy)
 {
+	INSTRUMENT(DRAW_AREA);
 	// This is only compatible with FXDCWindow when identity transforms.
 	if(!surface) {
 		fxerror("FXDCCairo::drawArea: DC not connected to drawable.\n");
@@ -669,8 +1842,9 @@ void FXDCCairo::drawArea(const FXDrawable* source,FXint sx,FXint sy,
 	if(!source || !source->id()) {
 		fxerror("FXDCCairo::drawArea: illegal source specified.\n");
 	}
-	//XCopyArea(DISPLAY(getApp()),source->id(),surface->id(),(GC)ctx,sx,sy,sw,sh,dx,dy);
-	cairo_surface_t * ss = (cairo_surface_t *)createServerSurface(source);
+	if (copyAreaServer(source, sx, sy, sw, sh, dx, dy))
+		return;
+	cairo_surface_t * ss = (cairo_surface_t *)createSourceSurface(source);
 	cairo_save(cc);
 	cairo_set_source_surface(cc, ss, dx-sx, dy-sy);
 	cairo_rectangle(cc, dx, dy, sw, sh);
@@ -684,13 +1858,14 @@ void FXDCCairo::drawArea(const FXDrawable* source,FXint sx,FXint sy,
 void FXDCCairo::drawArea(const FXDrawable* source,FXint sx,FXint sy,
 				FXint sw,FXint sh,FXint dx,FXint dy,FXint dw,FXint dh)
 {
+	INSTRUMENT(DRAW_AREA);
 	if(!surface) {
 		fxerror("FXDCCairo::drawArea: DC not connected to drawable.\n");
 	}
 	if(!source || !source->id()) {
 		fxerror("FXDCCairo::drawArea: illegal source specified.\n");
 	}
-	cairo_surface_t * ss = (cairo_surface_t *)createServerSurface(source);
+	cairo_surface_t * ss = (cairo_surface_t *)createSourceSurface(source);
 	cairo_save(cc);
 	cairo_translate(cc, dx, dy);
 	cairo_pattern_t * p = cairo_pattern_create_for_surface(ss);
@@ -710,6 +1885,7 @@ void FXDCCairo::drawArea(const FXDrawable* source,FXint sx,FXint sy,
 // Draw image
 void FXDCCairo::drawImage(const FXImage* image,FXint dx,FXint dy)
 {
+	INSTRUMENT(DRAW_IMAGE);
 	if(!surface) {
 		fxerror("FXDCCairo::drawImage: DC not connected to drawable.\n");
 	}
@@ -719,161 +1895,377 @@ void FXDCCairo::drawImage(const FXImage* image,FXint dx,FXint dy)
 	drawArea(image, 0, 0, image->getWidth(), image->getHeight(), dx, dy);
 }
 
-static FXuint fxColorToARGB32(FXColor clr)
+// Draw display list
+void FXDCCairo::drawDisplayList(const FXCairoDisplayList& list,FXint dx,FXint dy)
 {
-	// Writes 4 bytes at dest with Cairo ARGB32 format.
-	// ARGB32 has pre-multiplied alpha in the color components.
-	FXuint a = FXALPHAVAL(clr);
-	FXuint r = (a * FXREDVAL(clr) + 128)/255;
-	FXuint g = (a * FXGREENVAL(clr) + 128)/255;
-	FXuint b = (a * FXBLUEVAL(clr) + 128)/255;
-	return a<<24 | r<<16 | g<<8 | b;
+	INSTRUMENT(DRAW_DISPLAY_LIST);
+	if(!surface) {
+		fxerror("FXDCCairo::drawDisplayList: DC not connected to drawable.\n");
+	}
+	if (!list.isValid())
+		return;
+	cairo_save(cc);
+	cairo_set_source_surface(cc, (cairo_surface_t *)useRecording(list.getRecording()), dx, dy);
+	if (cr_mask && !cr_maskclip)
+		cairo_mask_surface(cc, ksurf, cx, cy);
+	else
+		cairo_paint(cc);
+	cairo_restore(cc);
 }
 
-static void fxClientBitmapToCairoA1(FXuint rows, 
-		FXuint fstride, FXuchar * f, 
-		FXuint cstride, FXuchar * c)
+/*
+	Converted image cache.
+	
+	Converting an image to a Cairo surface (and maybe fetching it from the server
+	first) is repeated every time an icon or bitmap is drawn.  The converted surfaces
+	are kept in an LRU cache with a memory budget.  See FXCairoCache.h.
+	
+	Clip paths made from regions and masks are cached alongside (see setClipRegion()
+	and setClipMask()).
+*/
+
+#ifndef WIN32
+
+// Clip path cache, keeping a copy of each X region to confirm a match, since
+// the key is only its bounds
+class FXCairoClipPathCache : public FXCairoPathCache
 {
-	for (FXuint row = 0; row < rows; ++row) {
-		memcpy(c, f, fstride);
-		c += cstride;
-		f += fstride;
+protected:
+	virtual void * copyShape(const void * shape) const
+	{
+		Region r = XCreateRegion();
+		XUnionRegion((Region)shape, r, r);
+		return r;
+	}
+	virtual void freeShape(void * shape) const
+	{
+		XDestroyRegion((Region)shape);
 	}
+	virtual FXbool sameShape(const void * a, const void * b) const
+	{
+		return XEqualRegion((Region)a, (Region)b) != 0;
+	}
+public:
+	virtual ~FXCairoClipPathCache() { clear(); }
+};
+
+#else
+
+typedef FXCairoPathCache FXCairoClipPathCache;
+
+#endif
+
+static FXCairoImageCache imageCache;
+static FXCairoClipPathCache clipPaths;
+
+
+// Look up converted image; none off the cache thread
+static inline cairo_surface_t * fxLookupImage(const FXCairoImageCache::Key & key)
+{
+	return fxSharedCaches() ? imageCache.lookup(key) : NULL;
 }
 
-static void fxClientBitmapToCairoARGB32(FXuint rows, FXuint w,
-		FXuint fstride, FXuchar * f, 
-		FXuint cstride, FXuint * c,
-		FXColor fg, FXColor bg)
+
+// Keep converted image, if on the cache thread
+static inline void fxStoreImage(const FXCairoImageCache::Key & key, cairo_surface_t * s)
 {
-	//printf("fxClientBitmapToCairoARGB32: rows=%u w=%u fs=%u cs=%u\n",
-	//	rows, w, fstride, cstride);
-	FXuint fgc = fxColorToARGB32(fg);
-	FXuint bgc = fxColorToARGB32(bg);
-	FXuint * r;
-	FXuchar pix;
-	FXuint i;
-	for (FXuint row = 0; row < rows; ++row) {
-		r = c;
-		for (i = 0; i < w>>3; ++i) {
-			pix = f[i];
-			for (FXuint j = 0; j < 8; ++j, pix >>= 1)
-				*(r++) = pix&1 ? fgc : bgc;
-		}
-		if (w&7) {
-			pix = f[i];
-			for (FXuint j = 0; j < w&7; ++j, pix >>= 1)
-				*(r++) = pix&1 ? fgc : bgc;
-		}
-		c = (FXuint *)((FXuchar *)c + cstride);
-		f += fstride;
-		//if (row == 248) return;
-	}
-}
-
-static void fxClientFXColorToCairoA1(FXuint rows,
-		FXuint fstride, FXColor * f, 
-		FXuint cstride, FXuchar * c,
-		FXuchar alpha_thresh,
-		FXdouble lum_thresh)
-{
-	// Fill a Cairo A1 surface with 1 bit if FXColor alpha >= alpha_thresh,
-	// and its NTSC luminescence is >= lum_thresh.
-	FXuint cols = fstride>>2;
-	FXuchar setbit;
-	for (FXuint row = 0; row < rows; ++row) {
-		for (FXuint i = 0; i < cols; ++i) {
-			if (!(i&7))
-				setbit = 1;
-			else
-				setbit <<= 1;
-			if (FXALPHAVAL(f[i]) >= alpha_thresh &&
-			    FXREDVAL(f[i])*0.3 + FXGREENVAL(f[i])*0.59 + FXBLUEVAL(f[i])*0.11 >= lum_thresh)
-				c[i>>3] |= setbit;
-			else
-				c[i>>3] &= ~setbit;
-		}
-		c += cstride;
-		f += fstride>>2;
+	if (fxSharedCaches())
+		imageCache.store(key, s);
+}
+
+
+// Invalidate conversions of an image, bitmap or icon
+void FXDCCairo::invalidateImage(const FXDrawable * image)
+{
+	imageCache.invalidate(image);
+	clipPaths.invalidate(image);
+}
+
+
+// Release all converted images
+void FXDCCairo::flushImageCache()
+{
+	imageCache.clear();
+}
+
+
+// Set converted image memory budget
+void FXDCCairo::setImageCacheBudget(FXuval bytes)
+{
+	imageCache.setBudget(bytes);
+}
+
+
+// Get converted image memory budget
+FXuval FXDCCairo::getImageCacheBudget()
+{
+	return imageCache.getBudget();
+}
+
+
+// Get converted image cache statistics
+void FXDCCairo::getImageCacheStats(FXCairoCacheStats & stats)
+{
+	stats = imageCache.getStats();
+}
+
+
+// Reset converted image cache counters
+void FXDCCairo::resetImageCacheStats()
+{
+	imageCache.resetStats();
+}
+
+
+/*
+	Pre-multiplied images.
+	
+	FXColor is not Cairo's pixel format (red and blue are swapped, and the colour is
+	not pre-multiplied), so every image is normally converted into a new surface.
+	Images whose buffers the application has filled in Cairo's format are listed
+	here, and their buffers are wrapped with cairo_image_surface_create_for_data().
+	The wrapper is kept in the image cache like a conversion, so it is only made
+	again after invalidateImage(), or when the data pointer or size changes.
+	
+	The mark is keyed by the object's address, and records the buffer, size and
+	X id the image had when marked (the id is taken later if it was not created
+	yet).  It only holds while they are the same, so an image deleted without
+	clearing the mark does not pass it on to a new image at the same address,
+	unless that has the very same buffer, size and id.  Then its colours are
+	wrong, but the buffer wrapped is still its own.  A stale mark is dropped when
+	it is found, and is otherwise just a few bytes.
+*/
+
+struct FXPremultipliedImage {
+	const FXColor * data;
+	FXint width, height;
+	FXID xid;
+};
+
+static FXHash premultipliedImages;
+static FXMutex premultipliedMutex;	// Images may be drawn on any thread
+
+
+// Return mark of image if it still matches, dropping a stale one.  The mutex
+// must be held.
+static FXPremultipliedImage * fxFindPremultiplied(const FXImage * image)
+{
+	FXPremultipliedImage * p = (FXPremultipliedImage *)premultipliedImages.find((void *)image);
+	if (!p)
+		return NULL;
+	if (!p->xid)
+		p->xid = image->id();		// Marked before create()
+	if (p->data != image->getData() || p->width != image->getWidth() ||
+	    p->height != image->getHeight() || p->xid != image->id()) {
+		premultipliedImages.remove((void *)image);
+		FXFREE(&p);
 	}
+	return p;
 }
 
 
-static void fxClientFXColorToCairoA1(FXuint rows,
-		FXuint fstride, FXColor * f, 
-		FXuint cstride, FXuchar * c,
-		FXColor transparent)
+// Mark image as holding pre-multiplied ARGB32
+void FXDCCairo::setImagePremultiplied(const FXImage * image, FXbool premultiplied)
 {
-	// Fill a Cairo A1 surface with 1 bit if FXColor is not 'transparent'.
-	FXuint cols = fstride>>2;
-	FXuchar setbit;
-	for (FXuint row = 0; row < rows; ++row) {
-		for (FXuint i = 0; i < cols; ++i) {
-			if (!(i&7))
-				setbit = 1;
-			else
-				setbit <<= 1;
-			if (f[i] != transparent)
-				c[i>>3] |= setbit;
-			else
-				c[i>>3] &= ~setbit;
-		}
-		c += cstride;
-		f += fstride>>2;
+	FXMutexLock lock(premultipliedMutex);
+	FXPremultipliedImage * p = fxFindPremultiplied(image);
+	if (premultiplied == (p != NULL))
+		return;
+	if (premultiplied) {
+		FXMALLOC(&p, FXPremultipliedImage, 1);
+		p->data = image->getData();
+		p->width = image->getWidth();
+		p->height = image->getHeight();
+		p->xid = image->id();
+		premultipliedImages.insert((void *)image, p);
+	}
+	else {
+		premultipliedImages.remove((void *)image);
+		FXFREE(&p);
 	}
+	imageCache.invalidate(image);
 }
 
 
-static void fxClientFXColorToCairoA8(FXuint rows,
-		FXuint fstride, FXColor * f, 
-		FXuint cstride, FXuchar * c)
+// Is image marked as pre-multiplied
+FXbool FXDCCairo::isImagePremultiplied(const FXImage * image)
 {
-	// Fill a Cairo A8 surface with alpha channel.
-	FXuint cols = fstride>>2;
-	for (FXuint row = 0; row < rows; ++row) {
-		for (FXuint i = 0; i < cols; ++i) {
-			c[i] = FXALPHAVAL(f[i]);
-		}
-		c += cstride;
-		f += fstride>>2;
+	FXMutexLock lock(premultipliedMutex);
+	return fxFindPremultiplied(image) != NULL;
+}
+
+
+static cairo_surface_t * fxWrapCairoClient(const FXImage * b)
+{
+	// Use the client buffer of a pre-multiplied image as it is.  ARGB32 rows
+	// are always 4*width bytes, as FOX has them.
+	FXCairoImageCache::Key key = { b, FXCairoImageCache::IMAGE_WRAPPED, 0, 0,
+	                               b->getData(), b->getWidth(), b->getHeight(), b->id() };
+	cairo_surface_t * s = fxLookupImage(key);
+	if (s)
+		return s;
+	INSTRUMENT_STATIC(CONVERT);
+	s = cairo_image_surface_create_for_data((unsigned char *)b->getData(), CAIRO_FORMAT_ARGB32,
+		b->getWidth(), b->getHeight(), b->getWidth()*sizeof(FXColor));
+	fxStoreImage(key, s);
+	return s;
+}
+
+
+// Invalidate rasters of a vector image
+void FXDCCairo::invalidateImage(const FXVectorImage * image)
+{
+	imageCache.invalidate(image);
+}
+
+
+// Return new reference to raster of vector image
+void * FXDCCairo::getVectorRaster(const FXVectorImage * image, FXint w, FXint h)
+{
+	FXCairoImageCache::Key key = { image, FXCairoImageCache::VECTOR_RASTER, (FXColor)w, (FXColor)h,
+	                               image->getRecording(), w, h, 0 };
+	cairo_surface_t * s = fxLookupImage(key);
+	if (s)
+		return s;
+	INSTRUMENT_STATIC(CONVERT);
+	s = (cairo_surface_t *)image->rasterize(w, h);
+	if (s)
+		fxStoreImage(key, s);
+	return s;
+}
+
+
+/*
+	Vector images.
+	
+	If the transformation only scales (and translates), the destination rectangle
+	is a whole number of device pixels in each direction, and a raster of exactly
+	that size is taken from the image cache.  It is drawn with a pattern matrix
+	rather than by changing the transformation, so that a clip mask still applies
+	in user space as for drawDisplayList().  When rotated, or when the raster
+	would take more than a quarter of the cache, the recording is drawn directly.
+*/
+
+// Draw vector image at natural size
+void FXDCCairo::drawVectorImage(const FXVectorImage* image,FXint dx,FXint dy)
+{
+	if(!image) {
+		fxerror("FXDCCairo::drawVectorImage: illegal image specified.\n");
 	}
+	drawVectorImage(image, dx, dy, (FXint)(image->getWidth()+0.5), (FXint)(image->getHeight()+0.5));
 }
 
 
-static void fxClientFXColorToCairoARGB32(FXuint rows,
-		FXuint fstride, FXColor * f,
-		FXuint cstride, FXuint * c)
+// Draw vector image scaled to dw*dh
+void FXDCCairo::drawVectorImage(const FXVectorImage* image,FXint dx,FXint dy,FXint dw,FXint dh)
 {
-	FXuint cols = FXMIN(fstride, cstride)>>2;
-	for (FXuint row = 0; row < rows; ++row) {
-		for (FXuint i = 0; i < cols; ++i) {
-			c[i] = fxColorToARGB32(f[i]);
+	INSTRUMENT(DRAW_VECTOR_IMAGE);
+	if(!surface) {
+		fxerror("FXDCCairo::drawVectorImage: DC not connected to drawable.\n");
+	}
+	if(!image) {
+		fxerror("FXDCCairo::drawVectorImage: illegal image specified.\n");
+	}
+	if (!image->isValid() || dw <= 0 || dh <= 0)
+		return;
+	if (transformFlags() & XFORM_AXIS) {
+		FXint pw = (FXint)(fabs(cr_ctm.xx)*dw + 0.5);
+		FXint ph = (FXint)(fabs(cr_ctm.yy)*dh + 0.5);
+		if (pw > 0 && ph > 0 && (FXuval)pw*ph*4 <= imageCache.getBudget()/4) {
+			cairo_surface_t * s = (cairo_surface_t *)getVectorRaster(image, pw, ph);
+			if (s) {
+				paintScaled(s, (double)pw/dw, (double)ph/dh, dx, dy, dw, dh, FALSE);
+				cairo_surface_destroy(s);
+				return;
+			}
 		}
-		c += cstride>>2;
-		f += fstride>>2;
 	}
+	paintScaled(useRecording(image->getRecording()), image->getWidth()/dw, image->getHeight()/dh, dx, dy, dw, dh, FALSE);
 }
 
-static void fxClientFXColorTransparencyToCairoARGB32(FXuint rows,
-		FXuint fstride, FXColor * f, 
-		FXuint cstride, FXuint * c,
-		FXColor transparent)
+
+// Fill dx,dy,dw,dh from source surface, scaled by sx,sy (source pixels per unit)
+void FXDCCairo::paintScaled(void * source, double sx, double sy, FXint dx, FXint dy, FXint dw, FXint dh, FXbool smooth)
 {
-	// Copies ARGB data directly, unless it matches the given "transparent"
-	// color, in which case it is made transparent black (0).
-	FXuint cols = FXMIN(fstride, cstride)>>2;
-	for (FXuint row = 0; row < rows; ++row) {
-		for (FXuint i = 0; i < cols; ++i) {
-			if (f[i] == transparent)
-				c[i] = 0;
-			else
-				c[i] = fxColorToARGB32(f[i]);
+	cairo_pattern_t * p = cairo_pattern_create_for_surface((cairo_surface_t *)source);
+	cairo_matrix_t m;
+	cairo_matrix_init_scale(&m, sx, sy);
+	cairo_matrix_translate(&m, -dx, -dy);
+	cairo_pattern_set_matrix(p, &m);
+	if (smooth)
+		cairo_pattern_set_filter(p, CAIRO_FILTER_BILINEAR);
+	cairo_save(cc);
+	cairo_set_source(cc, p);
+	cairo_rectangle(cc, dx, dy, dw, dh);
+	if (cr_mask && !cr_maskclip) {
+		cairo_clip(cc);
+		cairo_mask_surface(cc, ksurf, cx, cy);
+	}
+	else
+		cairo_fill(cc);
+	cairo_restore(cc);
+	cairo_pattern_destroy(p);
+}
+
+
+/*
+	Vector icons.
+	
+	The icon's size in device pixels picks a rung of its ladder, which is rasterized
+	once into the image cache, and scaled down with a bilinear filter when the size
+	is between rungs.  The steps of the ladder are at most 1.5 times, which is as
+	far as bilinear filtering goes without dropping detail.  Rotated icons are
+	drawn as vector images.  Above the top of the ladder the raster is the size
+	drawn, and as for vector images, one that would take more than a quarter of
+	the cache is not made: the recording is drawn directly instead.
+*/
+
+// Draw vector icon at default size
+void FXDCCairo::drawIcon(const FXVectorIcon* icon,FXint dx,FXint dy)
+{
+	if(!icon) {
+		fxerror("FXDCCairo::drawIcon: illegal icon specified.\n");
+	}
+	drawIcon(icon, dx, dy, icon->getSize());
+}
+
+
+// Draw vector icon with larger dimension size
+void FXDCCairo::drawIcon(const FXVectorIcon* icon,FXint dx,FXint dy,FXint size)
+{
+	INSTRUMENT(DRAW_ICON);
+	if(!surface) {
+		fxerror("FXDCCairo::drawIcon: DC not connected to drawable.\n");
+	}
+	if(!icon) {
+		fxerror("FXDCCairo::drawIcon: illegal icon specified.\n");
+	}
+	if (!icon->isValid() || size <= 0)
+		return;
+	FXint w, h;
+	icon->getIconSize(size, w, h);
+	if (!(transformFlags() & XFORM_AXIS)) {
+		drawVectorImage(icon, dx, dy, w, h);
+		return;
+	}
+	double pw = fabs(cr_ctm.xx)*w;
+	double ph = fabs(cr_ctm.yy)*h;
+	FXint px = (FXint)(FXMAX(pw, ph) + 0.5);
+	FXint rung = FXVectorIcon::getLadderSize(px);
+	FXint rw, rh;
+	icon->getIconSize(rung, rw, rh);
+	if (rw > 0 && rh > 0 && (FXuval)rw*rh*4 <= imageCache.getBudget()/4) {
+		cairo_surface_t * s = (cairo_surface_t *)getVectorRaster(icon, rw, rh);
+		if (s) {
+			paintScaled(s, (double)rw/w, (double)rh/h, dx, dy, w, h, rung != px);
+			cairo_surface_destroy(s);
+			return;
 		}
-		c += cstride>>2;
-		f += fstride>>2;
 	}
+	paintScaled(useRecording(icon->getRecording()), icon->getWidth()/w, icon->getHeight()/h, dx, dy, w, h, FALSE);
 }
 
+
 static cairo_surface_t * fxToCairoClient(const FXBitmap * b)
 {
 	// Return Cairo image surface with CAIRO_FORMAT_A1 (i.e. 1 bit alpha)
@@ -882,6 +2274,12 @@ static cairo_surface_t * fxToCairoClient(const FXBitmap * b)
 	// bitmap from the server.
 	// FIXME: it might be better to use cairo_xlib_surface_create_for_bitmap() for b->id(),
 	// and leave it server-side, but for now keep bitmaps (alpha masks) client-side.
+	FXCairoImageCache::Key key = { b, FXCairoImageCache::BITMAP_A1, 0, 0,
+	                               b->getData(), b->getWidth(), b->getHeight(), b->id() };
+	cairo_surface_t * s = fxLookupImage(key);
+	if (s)
+		return s;
+	INSTRUMENT_STATIC(CONVERT);
 	if (!b->getData()) {
 		// This is expensive (FOX gets it one pixel at a time) but it's one-time-only.
 		((FXBitmap *)b)->restore();	// This sets IMAGE_OWNED, so b's dtor will manage it.
@@ -892,10 +2290,12 @@ static cairo_surface_t * fxToCairoClient(const FXBitmap * b)
 	FXuint dstride = (b->getWidth()+7)>>3;
 	// Data from fox is not multiple of 32 bits per row, so we need to copy :-(
 	//FIXME: bug in pixman needs extra row allocated.
-	cairo_surface_t * s = cairo_image_surface_create(CAIRO_FORMAT_A1, b->getWidth(), b->getHeight()+1);
+	s = cairo_image_surface_create(CAIRO_FORMAT_A1, b->getWidth(), b->getHeight()+1);
 	fxClientBitmapToCairoA1(b->getHeight(), dstride, data, 
 		cairo_image_surface_get_stride(s), cairo_image_surface_get_data(s));
 	cairo_surface_mark_dirty(s);
+	key.data = data;
+	fxStoreImage(key, s);
 	return s;
 }
 
@@ -903,6 +2303,12 @@ static cairo_surface_t * fxToCairoClient(const FXBitmap * b, FXColor fg, FXColor
 {
 	// Similar to the above, except creates a full ARGB32 surface with fg for bitmap pixels
 	// which were 1, bg for zero pixels.
+	FXCairoImageCache::Key key = { b, FXCairoImageCache::BITMAP_ARGB32, fg, bg,
+	                               b->getData(), b->getWidth(), b->getHeight(), b->id() };
+	cairo_surface_t * s = fxLookupImage(key);
+	if (s)
+		return s;
+	INSTRUMENT_STATIC(CONVERT);
 	if (!b->getData()) {
 		((FXBitmap *)b)->restore();	// This sets IMAGE_OWNED, so b's dtor will manage it.
 	}
@@ -912,18 +2318,26 @@ static cairo_surface_t * fxToCairoClient(const FXBitmap * b, FXColor fg, FXColor
 	FXuint dstride = (b->getWidth()+7)>>3;
 	// Data from fox is not multiple of 32 bits per row, so we need to copy :-(
 	//FIXME: bug in pixman needs extra row allocated.
-	cairo_surface_t * s = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, b->getWidth(), b->getHeight()+1);
+	s = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, b->getWidth(), b->getHeight()+1);
 	//printf("fxToCairoClient: %s\n", cairo_status_to_string(cairo_surface_status(s)));
 	fxClientBitmapToCairoARGB32(b->getHeight(), b->getWidth(), dstride, data, 
 		cairo_image_surface_get_stride(s), (FXuint *)cairo_image_surface_get_data(s),
 		fg, bg);
 	cairo_surface_mark_dirty(s);
+	key.data = data;
+	fxStoreImage(key, s);
 	return s;
 }
 
 static cairo_surface_t * fxToCairoClient(const FXImage * b)
 {
 	// Copy client side FXColor pixels to an ARGB32 surface.
+	FXCairoImageCache::Key key = { b, FXCairoImageCache::IMAGE_ARGB32, 0, 0,
+	                               b->getData(), b->getWidth(), b->getHeight(), b->id() };
+	cairo_surface_t * s = fxLookupImage(key);
+	if (s)
+		return s;
+	INSTRUMENT_STATIC(CONVERT);
 	if (!b->getData()) {
 		((FXImage *)b)->restore();
 	}
@@ -932,16 +2346,24 @@ static cairo_surface_t * fxToCairoClient(const FXImage * b)
 		return NULL;
 	FXuint dstride = b->getWidth()*sizeof(FXColor);
 	//FIXME: bug in pixman needs extra row allocated.
-	cairo_surface_t * s = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, b->getWidth(), b->getHeight()+1);
+	s = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, b->getWidth(), b->getHeight()+1);
 	fxClientFXColorToCairoARGB32(b->getHeight(), dstride, data, 
 		cairo_image_surface_get_stride(s), (FXuint *)cairo_image_surface_get_data(s));
 	cairo_surface_mark_dirty(s);
+	key.data = data;
+	fxStoreImage(key, s);
 	return s;
 }
 
 static cairo_surface_t * fxToCairoClient(const FXImage * b, FXColor transparent)
 {
 	// As above, but mask out matching color to transparent black.
+	FXCairoImageCache::Key key = { b, FXCairoImageCache::IMAGE_KEYED, transparent, 0,
+	                               b->getData(), b->getWidth(), b->getHeight(), b->id() };
+	cairo_surface_t * s = fxLookupImage(key);
+	if (s)
+		return s;
+	INSTRUMENT_STATIC(CONVERT);
 	if (!b->getData()) {
 		((FXImage *)b)->restore();
 	}
@@ -950,11 +2372,13 @@ static cairo_surface_t * fxToCairoClient(const FXImage * b, FXColor transparent)
 		return NULL;
 	FXuint dstride = b->getWidth()*sizeof(FXColor);
 	//FIXME: bug in pixman needs extra row allocated.
-	cairo_surface_t * s = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, b->getWidth(), b->getHeight()+1);
+	s = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, b->getWidth(), b->getHeight()+1);
 	fxClientFXColorTransparencyToCairoARGB32(b->getHeight(), dstride, data, 
 		cairo_image_surface_get_stride(s), (FXuint *)cairo_image_surface_get_data(s),
 		transparent);
 	cairo_surface_mark_dirty(s);
+	key.data = data;
+	fxStoreImage(key, s);
 	return s;
 }
 
@@ -975,6 +2399,12 @@ static cairo_surface_t * fxToCairoClientMask(const FXImage * b, FXColor transpar
 	if (b->getOptions() & IMAGE_OPAQUE ||
 	    !(b->getData() || b->getOptions() & (IMAGE_ALPHACOLOR|IMAGE_ALPHAGUESS)))
 		return NULL;
+	FXCairoImageCache::Key key = { b, FXCairoImageCache::IMAGE_MASK, transparent, 0,
+	                               b->getData(), b->getWidth(), b->getHeight(), b->id() };
+	cairo_surface_t * s = fxLookupImage(key);
+	if (s)
+		return s;
+	INSTRUMENT_STATIC(CONVERT);
 	if (!b->getData())
 		((FXImage *)b)->restore();
 	FXColor * data = b->getData();
@@ -982,7 +2412,6 @@ static cairo_surface_t * fxToCairoClientMask(const FXImage * b, FXColor transpar
 		return NULL;
 	FXuint dstride = b->getWidth()*sizeof(FXColor);
 	//FIXME: bug in pixman needs extra row allocated.
-	cairo_surface_t * s;
 	if (b->getOptions() & (IMAGE_ALPHACOLOR|IMAGE_ALPHAGUESS)) {
 		s = cairo_image_surface_create(CAIRO_FORMAT_A1, b->getWidth(), b->getHeight()+1);
 		fxClientFXColorToCairoA1(b->getHeight(), dstride, data,
@@ -996,12 +2425,100 @@ static cairo_surface_t * fxToCairoClientMask(const FXImage * b, FXColor transpar
 			cairo_image_surface_get_stride(s), cairo_image_surface_get_data(s));
 	}
 	cairo_surface_mark_dirty(s);
+	key.data = data;
+	fxStoreImage(key, s);
+	return s;
+}
+
+/*
+	Stipples.
+
+	FXDCWindow stipples with the server-side pixmaps which FXApp makes for the
+	built-in patterns, but those are private to FXDCWindow.  We keep an
+	equivalent table of 8x8 patterns instead: STIPPLE_0 (all set) to STIPPLE_16
+	(all clear) are a 4x4 ordered dither, followed by the hatches.
+
+	A stipple is converted to an ARGB32 repeat pattern with fg for set pixels and
+	bg (FILL_OPAQUESTIPPLED) or transparent (FILL_STIPPLED) for clear pixels, so
+	that it paints in one pass like a tile.  The patterns are kept in the image
+	cache keyed by stipple and colours, so are shared by all DC's.  Unlike the
+	other conversions, they are made without the extra row, which would show up
+	when repeated.
+*/
+
+// Set where the 4x4 Bayer matrix { 0,8,2,10; 12,4,14,6; 3,11,1,9; 15,7,13,5 }
+// is less than 16-n for STIPPLE_n, in the FOX bitmap layout (bit 0 leftmost)
+static const FXuchar stippleBits[STIPPLE_CROSSDIAG+1][8] = {
+	{ 0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff },	// STIPPLE_0
+	{ 0xff,0xff,0xff,0xee,0xff,0xff,0xff,0xee },	// STIPPLE_1
+	{ 0xff,0xbb,0xff,0xee,0xff,0xbb,0xff,0xee },	// STIPPLE_2
+	{ 0xff,0xbb,0xff,0xaa,0xff,0xbb,0xff,0xaa },	// STIPPLE_3
+	{ 0xff,0xaa,0xff,0xaa,0xff,0xaa,0xff,0xaa },	// STIPPLE_4
+	{ 0xff,0xaa,0xdd,0xaa,0xff,0xaa,0xdd,0xaa },	// STIPPLE_5
+	{ 0x77,0xaa,0xdd,0xaa,0x77,0xaa,0xdd,0xaa },	// STIPPLE_6
+	{ 0x77,0xaa,0x55,0xaa,0x77,0xaa,0x55,0xaa },	// STIPPLE_7
+	{ 0x55,0xaa,0x55,0xaa,0x55,0xaa,0x55,0xaa },	// STIPPLE_8
+	{ 0x55,0xaa,0x55,0x88,0x55,0xaa,0x55,0x88 },	// STIPPLE_9
+	{ 0x55,0x22,0x55,0x88,0x55,0x22,0x55,0x88 },	// STIPPLE_10
+	{ 0x55,0x22,0x55,0x00,0x55,0x22,0x55,0x00 },	// STIPPLE_11
+	{ 0x55,0x00,0x55,0x00,0x55,0x00,0x55,0x00 },	// STIPPLE_12
+	{ 0x55,0x00,0x44,0x00,0x55,0x00,0x44,0x00 },	// STIPPLE_13
+	{ 0x11,0x00,0x44,0x00,0x11,0x00,0x44,0x00 },	// STIPPLE_14
+	{ 0x11,0x00,0x00,0x00,0x11,0x00,0x00,0x00 },	// STIPPLE_15
+	{ 0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00 },	// STIPPLE_16
+	{ 0xff,0x00,0x00,0x00,0xff,0x00,0x00,0x00 },	// STIPPLE_HORZ
+	{ 0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11 },	// STIPPLE_VERT
+	{ 0xff,0x11,0x11,0x11,0xff,0x11,0x11,0x11 },	// STIPPLE_CROSS
+	{ 0x80,0x40,0x20,0x10,0x08,0x04,0x02,0x01 },	// STIPPLE_DIAG
+	{ 0x01,0x02,0x04,0x08,0x10,0x20,0x40,0x80 },	// STIPPLE_REVDIAG
+	{ 0x81,0x42,0x24,0x18,0x18,0x24,0x42,0x81 },	// STIPPLE_CROSSDIAG
+};
+
+
+// Return bits (FOX bitmap layout) of built-in stipple pattern
+static const FXuchar * fxStippleBits(FXStipplePattern pat)
+{
+	return stippleBits[pat];
+}
+
+
+static cairo_surface_t * fxToCairoStipple(const FXBitmap * b, FXStipplePattern pat, FXColor fg, FXColor bg)
+{
+	// Repeat pattern for stipple bitmap b, or built-in pattern pat if b is NULL.
+	// Returns new reference, or NULL if the bitmap has no data.
+	const FXuchar * data;
+	FXint w = 8;
+	FXint h = 8;
+	if (b) {
+		if (!b->getData())
+			((FXBitmap *)b)->restore();
+		data = b->getData();
+		if (!data)
+			return NULL;
+		w = b->getWidth();
+		h = b->getHeight();
+	}
+	else
+		data = fxStippleBits(pat);
+	FXCairoImageCache::Key key = { b ? (const void *)b : (const void *)data,
+	                               FXCairoImageCache::STIPPLE_ARGB32, fg, bg, data, w, h, b ? b->id() : 0 };
+	cairo_surface_t * s = fxLookupImage(key);
+	if (s)
+		return s;
+	INSTRUMENT_STATIC(CONVERT);
+	s = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, w, h);
+	fxClientBitmapToCairoARGB32(h, w, (w+7)>>3, data,
+		cairo_image_surface_get_stride(s), (FXuint *)cairo_image_surface_get_data(s),
+		fg, bg);
+	cairo_surface_mark_dirty(s);
+	fxStoreImage(key, s);
 	return s;
 }
 
 // Draw bitmap
 void FXDCCairo::drawBitmap(const FXBitmap* bitmap,FXint dx,FXint dy)
 {
+	INSTRUMENT(DRAW_BITMAP);
 	if(!surface) fxerror("FXDCCairo::drawBitmap: DC not connected to drawable.\n");
 	if(!bitmap || !bitmap->id()) fxerror("FXDCCairo::drawBitmap: illegal bitmap specified.\n");
 	//XCopyPlane(DISPLAY(getApp()),bitmap->id(),surface->id(),(GC)ctx,0,0,bitmap->width,bitmap->height,dx,dy,1);
@@ -1009,9 +2526,9 @@ void FXDCCairo::drawBitmap(const FXBitmap* bitmap,FXint dx,FXint dy)
 	XCopyPlane is like a FillOpaqueStippled using the source plane as a bitmap.  In this case the
 	source plane is the bitmap itself.
 	
-	Note that use of fxToCairoClient() represents an inefficiency.  We need to develop
-	a specialized FXImage/FXBitmap class which is more compatible with Cairo.  e.g. it could
-	cache the cairo_surface_t.
+	Note that use of fxToCairoClient() represents an inefficiency, although the
+	converted surface is cached (per fg/bg pair) so it is only repeated when the
+	bitmap changes.
 */
 	cairo_surface_t * s = fxToCairoClient(bitmap, fg, bg);
 	if (!s) {
@@ -1024,143 +2541,200 @@ void FXDCCairo::drawBitmap(const FXBitmap* bitmap,FXint dx,FXint dy)
 	cairo_rectangle(cc, dx, dy, bitmap->getWidth(), bitmap->getHeight());
 	cairo_fill(cc);
 	cairo_restore(cc);
-	cairo_surface_destroy(s);	// Encounters mem corruption!  WTF?
+	cairo_surface_destroy(s);
+	
+}
+
+
+/*
+	Icons.
+	
+	Drawing an icon takes the server-side pixels through the icon's mask, and the
+	shaded and sunken variants add two or three more masked operations on top.
+	Since none of these depend on what is underneath (the sunken icon starts with
+	an opaque base colour), each variant is drawn once onto a transparent ARGB32
+	surface and kept in the image cache.  Drawing is then a single blit.  The key
+	includes the colour used for the variant, so changing the selback or base
+	colour of the application just misses the cache; the old surfaces age out.
 	
+	The normal and shaded variants only use OVER, which gives the same result
+	drawn on a transparent surface first.  The sunken variant uses the luminosity
+	operator, so this only holds where the mask is 0 or 1: a colour-keyed (A1)
+	mask, or none.  An icon with an alpha channel (A8 mask) has partly covered
+	edges, which would blend with transparency rather than with what is under
+	them, so its sunken variant is drawn directly each time instead.
+*/
+
+// Fill with the current source through mask m, or the whole w x h rectangle
+static void fxMaskIcon(cairo_t * ic, cairo_surface_t * m, FXint w, FXint h)
+{
+	if (m)
+		cairo_mask_surface(ic, m, 0, 0);
+	else {
+		cairo_rectangle(ic, 0, 0, w, h);
+		cairo_fill(ic);
+	}
+}
+
+
+// Return new reference to icon variant (ICON_NORMAL, ICON_SHADED or ICON_SUNKEN)
+void * FXDCCairo::createIconSurface(const FXIcon * icon, FXuint kind)
+{
+	FXint w = icon->getWidth();
+	FXint h = icon->getHeight();
+	FXColor clr = 0;
+	if (kind == FXCairoImageCache::ICON_SHADED)
+		clr = getApp()->getSelbackColor();
+	else if (kind == FXCairoImageCache::ICON_SUNKEN)
+		clr = getApp()->getBaseColor();
+	FXCairoImageCache::Key key = { icon, kind, icon->getTransparentColor(), clr,
+	                               icon->getData(), w, h, icon->id() };
+	cairo_surface_t * s = fxLookupImage(key);
+	if (s)
+		return s;
+	INSTRUMENT(ICON_SURFACE);
+	
+	// May return NULL if all opaque.  Otherwise, m is alpha mask
+	cairo_surface_t * m = fxToCairoClientMask(icon, icon->getTransparentColor());
+	cairo_surface_t * ss = (cairo_surface_t *)createServerSurface(icon);
+	s = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, w, h);
+	cairo_t * ic = cairo_create(s);
+	switch (kind) {
+	default:
+	case FXCairoImageCache::ICON_NORMAL:
+		cairo_set_source_surface(ic, ss, 0, 0);
+		fxMaskIcon(ic, m, w, h);
+		break;
+	case FXCairoImageCache::ICON_SHADED:
+		// With Xlib, we blit the icon then stipple 50% coverage with the "selection background"
+		// color.  The equivalent with Cairo is to set dest = 0.5 selback + 0.5 image as a blending
+		// op.  Best imitation is by drawing the icon as usual, then overdrawing using a partially
+		// transparent color.
+		cairo_set_source_surface(ic, ss, 0, 0);
+		fxMaskIcon(ic, m, w, h);
+		cairo_set_source_rgba(ic, FXREDVAL(clr)/255., FXGREENVAL(clr)/255., 
+									FXBLUEVAL(clr)/255., 0.5);
+		fxMaskIcon(ic, m, w, h);
+		break;
+	case FXCairoImageCache::ICON_SUNKEN:
+		// This uses the 'etch' mask to draw in white at offset(1,1) then 85% of "base color" at
+		// offset (0,0).
+		// There is no need, however, to be too literal.  We can draw a "sunken" icon (i.e. indicating
+		// non-selectability) using the CAIRO_OPERATOR_HSL_LUMINOSITY operator.  This retains
+		// the hue and saturation of the destination, setting just the luminosity of the icon.
+		// Optionally we can lower the image contrast by overlaying semi-transparent background color.
+		
+		// Place base color background
+		cairo_set_source_rgba(ic, FXREDVAL(clr)/255., FXGREENVAL(clr)/255., 
+									FXBLUEVAL(clr)/255., 1.0);
+		fxMaskIcon(ic, m, w, h);
+		
+		// Draw icon in matching monochrome
+		cairo_set_operator(ic, CAIRO_OPERATOR_HSL_LUMINOSITY);
+		cairo_set_source_surface(ic, ss, 0, 0);
+		fxMaskIcon(ic, m, w, h);
+		
+		// Reduce contrast, still with the luminosity operator
+		cairo_set_source_rgba(ic, FXREDVAL(clr)/255., FXGREENVAL(clr)/255., 
+									FXBLUEVAL(clr)/255., 0.7);
+		fxMaskIcon(ic, m, w, h);
+		break;
+	}
+	cairo_destroy(ic);
+	cairo_surface_destroy(ss);
+	if (m) cairo_surface_destroy(m);
+	cairo_surface_flush(s);
+	key.data = icon->getData();		// Mask conversion may have restored it
+	fxStoreImage(key, s);
+	return s;
+}
+
+
+// Blit icon variant
+void FXDCCairo::paintIcon(const FXIcon * icon, FXuint kind, FXint dx, FXint dy)
+{
+	cairo_surface_t * s = (cairo_surface_t *)createIconSurface(icon, kind);
+	cairo_save(cc);
+	cairo_set_source_surface(cc, s, dx, dy);
+	cairo_rectangle(cc, dx, dy, icon->getWidth(), icon->getHeight());
+	cairo_fill(cc);
+	cairo_restore(cc);
+	cairo_surface_destroy(s);
+}
+
+
+// Draw sunken icon with alpha mask m directly, as in createIconSurface()
+void FXDCCairo::paintIconSunken(const FXIcon * icon, void * m, FXint dx, FXint dy)
+{
+	cairo_surface_t * ss = (cairo_surface_t *)createServerSurface(icon);
+	FXColor clr = getApp()->getBaseColor();
+	cairo_save(cc);
+	cairo_set_source_rgba(cc, FXREDVAL(clr)/255., FXGREENVAL(clr)/255., 
+								FXBLUEVAL(clr)/255., 1.0);
+	cairo_mask_surface(cc, (cairo_surface_t *)m, dx, dy);
+	cairo_set_operator(cc, CAIRO_OPERATOR_HSL_LUMINOSITY);
+	cairo_set_source_surface(cc, ss, dx, dy);
+	cairo_mask_surface(cc, (cairo_surface_t *)m, dx, dy);
+	cairo_set_source_rgba(cc, FXREDVAL(clr)/255., FXGREENVAL(clr)/255., 
+								FXBLUEVAL(clr)/255., 0.7);
+	cairo_mask_surface(cc, (cairo_surface_t *)m, dx, dy);
+	cairo_restore(cc);
+	cairo_surface_destroy(ss);
 }
 
 
 // Draw a vanilla icon
 void FXDCCairo::drawIcon(const FXIcon* icon,FXint dx,FXint dy)
 {
+	INSTRUMENT(DRAW_ICON);
 	if(!surface) {
 		fxerror("FXDCCairo::drawIcon: DC not connected to drawable.\n");
 	}
 	if(!icon || !icon->id() /*|| !icon->shape*/) {
 		fxerror("FXDCCairo::drawIcon: illegal icon specified.\n");
 	}
-	cairo_surface_t * s = fxToCairoClientMask(icon, icon->getTransparentColor());
-	// May return NULL if all  opaque.  Otherwise, s is alpha mask
-	cairo_save(cc);
-	cairo_surface_t * ss = (cairo_surface_t *)createServerSurface(icon);
-	cairo_set_source_surface(cc, ss, dx, dy);
-	if (s)
-		cairo_mask_surface(cc, s, dx, dy);
-	else {
-		cairo_rectangle(cc, dx, dy, icon->getWidth(), icon->getHeight());
-		cairo_fill(cc);
-	}
-	cairo_restore(cc);
-	cairo_surface_destroy(ss);
-	if (s) cairo_surface_destroy(s);
+	paintIcon(icon, FXCairoImageCache::ICON_NORMAL, dx, dy);
 }
 
 
 // Draw a shaded icon, like when it is selected
 void FXDCCairo::drawIconShaded(const FXIcon* icon,FXint dx,FXint dy)
 {
+	INSTRUMENT(DRAW_ICON_SHADED);
 	if(!surface) {
 		fxerror("FXDCCairo::drawIconShaded: DC not connected to drawable.\n");
 	}
 	if(!icon || !icon->id() /*|| !icon->shape */) {
 		fxerror("FXDCCairo::drawIconShaded: illegal icon specified.\n");
 	}
-/*
-	With Xlib, we blit the icon then stipple 50% coverage with the "selection background" color.
-	The equivalent with Cairo is to set dest = 0.5 selback + 0.5 image as a belending op.
-	Best imitation is by drawing the icon as usual, then overdrawing using a partially transparent
-	color.
-*/
-	cairo_surface_t * s = fxToCairoClientMask(icon, icon->getTransparentColor());
-	cairo_save(cc);
-	cairo_surface_t * ss = (cairo_surface_t *)createServerSurface(icon);
-	FXColor clr = getApp()->getSelbackColor();
-	cairo_set_source_surface(cc, ss, dx, dy);
-	if (s) {
-		cairo_mask_surface(cc, s, dx, dy);
-		cairo_set_source_rgba(cc, FXREDVAL(clr)/255., FXGREENVAL(clr)/255., 
-									FXBLUEVAL(clr)/255., 0.5);
-		cairo_mask_surface(cc, s, dx, dy);
-	}
-	else {
-		cairo_rectangle(cc, dx, dy, icon->getWidth(), icon->getHeight());
-		cairo_fill_preserve(cc);
-		cairo_set_source_rgba(cc, FXREDVAL(clr)/255., FXGREENVAL(clr)/255., 
-									FXBLUEVAL(clr)/255., 0.5);
-		cairo_fill(cc);
-	}
-	cairo_restore(cc);
-	cairo_surface_destroy(ss);
-	if (s) cairo_surface_destroy(s);
-
+	paintIcon(icon, FXCairoImageCache::ICON_SHADED, dx, dy);
 }
 
 
 // This draws a sunken icon
 void FXDCCairo::drawIconSunken(const FXIcon* icon,FXint dx,FXint dy)
 {
-/*
-	This uses the 'etch' mask to draw in white at offset(1,1) then 85% of "base color" at
-	offset (0,0).
-	There is no need, however, to be too literal.  We can draw a "sunken" icon (i.e. indicating
-	non-selectability) using the CAIRO_OPERATOR_HSL_LUMINOSITY operator.  This retains
-	the hue and saturation of the destination, setting just the luminosity of the icon.
-	Optionally we can lower the image contrast by overlaying semi-transparent background color.
-*/
+	INSTRUMENT(DRAW_ICON_SUNKEN);
 	if(!surface) {
 		fxerror("FXDCCairo::drawIconSunken: DC not connected to drawable.\n");
 	}
 	if(!icon || !icon->id() /*|| !icon->etch */) {
 		fxerror("FXDCCairo::drawIconSunken: illegal icon specified.\n");
 	}
-	
-	cairo_surface_t * s = fxToCairoClientMask(icon, icon->getTransparentColor());
-	cairo_save(cc);
-	cairo_surface_t * ss = (cairo_surface_t *)createServerSurface(icon);
-	FXColor clr = getApp()->getBaseColor();
-	
-	// Place base color background
-	cairo_set_source_rgba(cc, FXREDVAL(clr)/255., FXGREENVAL(clr)/255., 
-								FXBLUEVAL(clr)/255., 1.0);
-	if (s) {
-		cairo_mask_surface(cc, s, dx, dy);
-	}
-	else {
-		cairo_rectangle(cc, dx, dy, icon->getWidth(), icon->getHeight());
-		cairo_fill(cc);
-	}
-	
-	// Draw icon in matching monochrome
-	cairo_set_operator(cc, CAIRO_OPERATOR_HSL_LUMINOSITY);
-	cairo_set_source_surface(cc, ss, dx, dy);
-	if (s) {
-		cairo_mask_surface(cc, s, dx, dy);
-	}
-	else {
-		cairo_rectangle(cc, dx, dy, icon->getWidth(), icon->getHeight());
-		cairo_fill(cc);
-	}
-	
-	// Reduce contrast by alpha-over
-	cairo_set_source_rgba(cc, FXREDVAL(clr)/255., FXGREENVAL(clr)/255., 
-								FXBLUEVAL(clr)/255., 0.7);
-	if (s) {
-		cairo_mask_surface(cc, s, dx, dy);
-	}
-	else {
-		cairo_rectangle(cc, dx, dy, icon->getWidth(), icon->getHeight());
-		cairo_fill(cc);
-	}
-	
-	cairo_restore(cc);
-	cairo_surface_destroy(ss);
-	if (s) cairo_surface_destroy(s);
-
+	cairo_surface_t * m = fxToCairoClientMask(icon, icon->getTransparentColor());
+	if (m && cairo_image_surface_get_format(m) == CAIRO_FORMAT_A8)
+		paintIconSunken(icon, m, dx, dy);
+	else
+		paintIcon(icon, FXCairoImageCache::ICON_SUNKEN, dx, dy);
+	if (m)
+		cairo_surface_destroy(m);
 }
 
 
 // Draw hash box
 void FXDCCairo::drawHashBox(FXint x,FXint y,FXint w,FXint h,FXint b)
 {
+	INSTRUMENT(DRAW_HASH_BOX);
 	XGCValues gcv;
 	if(!surface) {
 		fxerror("FXDCCairo::drawHashBox: DC not connected to drawable.\n");
@@ -1180,6 +2754,7 @@ void FXDCCairo::drawHashBox(FXint x,FXint y,FXint w,FXint h,FXint b)
 // Draw focus rectangle
 void FXDCCairo::drawFocusRectangle(FXint x,FXint y,FXint w,FXint h)
 {
+	INSTRUMENT(DRAW_FOCUS_RECTANGLE);
 	XGCValues gcv;
 	if(!surface) {
 		fxerror("FXDCCairo::drawFocusRectangle: DC not connected to drawable.\n");
@@ -1207,12 +2782,11 @@ void FXDCCairo::sharpOffset(FXbool on)
 			// Hack: if identity transform, and odd line width, then transform offset by 0.5
 			// pixels.  This makes horizontal/vertical odd-pixel-width lines "sharp" because they are not
 			// anti-aliased onto half adjacent lines.
-			double xx = 1.;
-			double yy = 1.;
-			cairo_device_to_user_distance(cc, &xx, &yy);
-			if (xx == 1. && yy == 1.) {
+			if (transformFlags() & XFORM_UNIT) {
 				sharp_offset = TRUE;
 				cairo_translate(cc, 0.5, 0.5);
+				cr_ctm.x0 += 0.5;
+				cr_ctm.y0 += 0.5;
 			}
 		}
 	}
@@ -1220,6 +2794,8 @@ void FXDCCairo::sharpOffset(FXbool on)
 		if (sharp_offset) {
 			sharp_offset = FALSE;
 			cairo_translate(cc, -0.5, -0.5);
+			cr_ctm.x0 -= 0.5;
+			cr_ctm.y0 -= 0.5;
 		}
 	}
 }
@@ -1241,7 +2817,7 @@ void FXDCCairo::setSourceTile()
 		if (tile != cr_tile) {
 			if (tsurf)
 				cairo_surface_destroy(tsurf);
-			tsurf = (cairo_surface_t *)createServerSurface(tile);
+			tsurf = (cairo_surface_t *)createSourceSurface(tile);
 		}
 		cairo_set_source_surface(cc, tsurf, tx, ty);
 		cairo_pattern_t * pat = cairo_get_source(cc);
@@ -1253,6 +2829,36 @@ void FXDCCairo::setSourceTile()
 	}
 }
 
+void FXDCCairo::setSourceStipple(FXbool opaque)
+{
+	// Stipple pixels map to device pixels, so sample without filtering.
+	FXColor sbg = opaque ? bg : 0;
+	if (src != STIPPLE || stipple != cr_stipple || pattern != cr_pattern
+		|| fg != cr_sfg || sbg != cr_sbg || cr_tx != tx || cr_ty != ty) {
+		if (!ssurf || stipple != cr_stipple || pattern != cr_pattern
+			|| fg != cr_sfg || sbg != cr_sbg) {
+			if (ssurf)
+				cairo_surface_destroy(ssurf);
+			ssurf = fxToCairoStipple(stipple, pattern, fg, sbg);
+			cr_stipple = stipple;
+			cr_pattern = pattern;
+			cr_sfg = fg;
+			cr_sbg = sbg;
+		}
+		if (!ssurf) {
+			setSourceRGBA(fg);
+			return;
+		}
+		cairo_set_source_surface(cc, ssurf, tx, ty);
+		cairo_pattern_t * pat = cairo_get_source(cc);
+		cairo_pattern_set_extend(pat, CAIRO_EXTEND_REPEAT);
+		cairo_pattern_set_filter(pat, CAIRO_FILTER_NEAREST);
+		cr_tx = tx;
+		cr_ty = ty;
+		src = STIPPLE;
+	}
+}
+
 void FXDCCairo::setSource(FXbool alternative)
 {
 	// Set appropriate source for normal fill/stroke operations
@@ -1270,11 +2876,11 @@ void FXDCCairo::setSource(FXbool alternative)
 	case FILL_TILED:
 		setSourceTile();
 		break;
-	case FILL_STIPPLED: //FIXME
-		setSourceTile();
+	case FILL_STIPPLED:
+		setSourceStipple(FALSE);
 		break;
 	case FILL_OPAQUESTIPPLED:
-		setSourceTile();
+		setSourceStipple(TRUE);
 		break;
 	}
 }
@@ -1282,16 +2888,13 @@ void FXDCCairo::setSource(FXbool alternative)
 
 void FXDCCairo::paint(FXbool stroke, FXbool fill, FXbool preserve)
 {
+	INSTRUMENT(PAINT);
 	// Perform cairo_stroke()/fill (or both) with special hacks to emulate FXDC.
 	// Optionally preserve path.
 	// By default, fill is done with bg color if also stroking, else fg.
 	
-	if (cr_mask) {
-		cairo_push_group(cc);
-		//FIXME: ideally we want to clip to the mask extent (cx,cy,w,h)
-		// but we don't want to trash the current path.  Need a way of saving/restoring
-		// the current path.
-	}
+	if (cr_mask && !cr_maskclip)
+		pushMask();
 	
 	if (fill) {
 		if (stroke)
@@ -1308,10 +2911,8 @@ void FXDCCairo::paint(FXbool stroke, FXbool fill, FXbool preserve)
 			if (!width) {
 				// Find equivalent of 1 device pixel width.  This only works if used under the
 				// current transform.
-				double xx = 1.;
-				double yy = 1.;
-				cairo_device_to_user_distance(cc, &xx, &yy);
-				cairo_set_line_width(cc, FXMAX(xx, yy));
+				transformFlags();
+				cairo_set_line_width(cc, FXMAX(cr_pixw, cr_pixh));
 			}
 			else
 				cairo_set_line_width(cc, width);
@@ -1349,28 +2950,28 @@ void FXDCCairo::paint(FXbool stroke, FXbool fill, FXbool preserve)
 			cairo_stroke(cc);
 		
 	}
-	if (cr_mask) {
-		cairo_pop_group_to_source(cc);
-		cairo_mask_surface(cc, ksurf, cx, cy);
-	}
+	if (cr_mask && !cr_maskclip)
+		popMask();
 }
 
 void FXDCCairo::paintTextLayout(double x, double y, FXbool fillbg)
 {
-	if (cr_mask) {
-		cairo_push_group(cc);
-	}
+	INSTRUMENT(PAINT_TEXT);
+	if (cr_mask && !cr_maskclip)
+		pushMask();
 
-	// x,y are starting baseline position
+	// x,y are starting baseline position.  The source is set outside the
+	// cairo_save(), so that it is still the one recorded in src afterwards.
+	setSource();
 	cairo_save(cc);
 	cairo_translate(cc, x, y);
 	if (font->getAngle()) {
 		cairo_rotate(cc, font->getAngle()/-64.*DTOR);
 	}
-	y = -pango_layout_get_baseline(layout)/PANGO_SCALE;
+	y = -pango_layout_get_baseline(tlayout)/PANGO_SCALE;
 	if (fillbg) {
 		PangoRectangle logext;
-		pango_layout_get_extents(layout, NULL, &logext);
+		pango_layout_get_extents(tlayout, NULL, &logext);
 		cairo_save(cc);
 		cairo_rectangle(cc, logext.x/PANGO_SCALE, y + logext.y/PANGO_SCALE,
 							logext.width/PANGO_SCALE, logext.height/PANGO_SCALE);
@@ -1380,14 +2981,11 @@ void FXDCCairo::paintTextLayout(double x, double y, FXbool fillbg)
 		cairo_restore(cc);
 	}
 	cairo_move_to(cc, 0, y);
-	setSource();
-	pango_cairo_update_layout(cc, layout);
-	pango_cairo_show_layout (cc, layout);
+	pango_cairo_update_layout(cc, tlayout);
+	pango_cairo_show_layout (cc, tlayout);
 	cairo_restore(cc);
-	if (cr_mask) {
-		cairo_pop_group_to_source(cc);
-		cairo_mask_surface(cc, ksurf, cx, cy);
-	}
+	if (cr_mask && !cr_maskclip)
+		popMask();
 	
 }
 
@@ -1558,7 +3156,7 @@ void FXDCCairo::setTile(FXImage* image,FXint dx,FXint dy)
 // Set stipple bitmap
 void FXDCCairo::setStipple(FXBitmap* bitmap,FXint dx,FXint dy)
 {
-	// Stippling is not efficient.
+	// Converted to a repeat pattern when first used to fill (see setSourceStipple()).
 	stipple=bitmap;
 	pattern=STIPPLE_NONE;
 	tx=dx;
@@ -1586,23 +3184,168 @@ void FXDCCairo::setStipple(FXStipplePattern pat,FXint dx,FXint dy)
 }
 
 
+/*
+	Clip paths.
+	
+	A region is a list of rectangles, which we add to the path and clip to.  With
+	an identity transform the rectangles are pixel aligned, so Cairo (pixman) can
+	use its fast rectangular clipping.  The path made from a region is cached in
+	clipPaths, so repeated exposes with the same multi-rectangle damage just
+	append the path again.
+	
+	Xlib has no public call to list the rectangles of a region, so the cache is
+	keyed by the bounds from XClipBox(), and each entry keeps a copy of its region
+	to confirm a hit with XEqualRegion().  Only on a miss are the rectangles found,
+	with XRectInRegion(), band by band as Xlib keeps them: the spans of the top row
+	by binary search along it, then the height for which the spans (and the gaps
+	between them) stay the same, also by binary search.
+	
+	On Windows, GetRegionData() lists the rectangles, which are the key.
+*/
+
+#ifndef WIN32
+
+// Start of the first span of row y at or after x, where one is known to start
+// before x1
+static FXint fxSpanStart(Region rgn, FXint x, FXint x1, FXint y)
+{
+	// Smallest e in (x, x1] with pixels x..e-1 not all outside
+	FXint lo = x, hi = x1;
+	while (hi - lo > 1) {
+		FXint m = lo + (hi - lo)/2;
+		if (XRectInRegion(rgn, x, y, m-x, 1) != RectangleOut)
+			hi = m;
+		else
+			lo = m;
+	}
+	return hi - 1;
+}
+
+
+// End of the span of row y starting at start, no further than x1
+static FXint fxSpanEnd(Region rgn, FXint start, FXint x1, FXint y)
+{
+	// Largest e in [start+1, x1] with pixels start..e-1 all inside
+	FXint lo = start + 1, hi = x1 + 1;
+	while (hi - lo > 1) {
+		FXint m = lo + (hi - lo)/2;
+		if (XRectInRegion(rgn, start, y, m-start, 1) == RectangleIn)
+			lo = m;
+		else
+			hi = m;
+	}
+	return lo;
+}
+
+
+// Return TRUE if the spans of row y, and the gaps between them within x0..x1,
+// are the same for h rows
+static FXbool fxSameBand(Region rgn, const FXint * spans, FXint n, FXint x0, FXint x1, FXint y, FXint h)
+{
+	FXint x = x0;
+	for (FXint i = 0; i < n; i += 2) {
+		if (spans[i] > x && XRectInRegion(rgn, x, y, spans[i]-x, h) != RectangleOut)
+			return FALSE;
+		if (XRectInRegion(rgn, spans[i], y, spans[i+1]-spans[i], h) != RectangleIn)
+			return FALSE;
+		x = spans[i+1];
+	}
+	return x >= x1 || XRectInRegion(rgn, x, y, x1-x, h) == RectangleOut;
+}
+
+
+// Height of the band starting at row y with the given spans, at most hmax
+static FXint fxBandHeight(Region rgn, const FXint * spans, FXint n, FXint x0, FXint x1, FXint y, FXint hmax)
+{
+	FXint lo = 1, hi = hmax + 1;
+	while (hi - lo > 1) {
+		FXint m = lo + (hi - lo)/2;
+		if (fxSameBand(rgn, spans, n, x0, x1, y, m))
+			lo = m;
+		else
+			hi = m;
+	}
+	return lo;
+}
+
+
+// Add the rectangles of an X region with bounds box to the path
+static void fxPathXRegion(cairo_t * cc, Region rgn, const XRectangle & box)
+{
+	FXint x0 = box.x;
+	FXint x1 = box.x + box.width;
+	FXint y1 = box.y + box.height;
+	FXint * spans = NULL;	// Start and end of each span in the band
+	FXint nalloc = 0;
+	for (FXint y = box.y; y < y1; ) {
+		FXint n = 0;
+		FXint x = x0;
+		while (x < x1 && XRectInRegion(rgn, x, y, x1-x, 1) != RectangleOut) {
+			FXint start = fxSpanStart(rgn, x, x1, y);
+			FXint end = fxSpanEnd(rgn, start, x1, y);
+			if (n+2 > nalloc) {
+				nalloc = nalloc ? 2*nalloc : 16;
+				FXRESIZE(&spans, FXint, nalloc);
+			}
+			spans[n++] = start;
+			spans[n++] = end;
+			x = end;
+		}
+		// With no spans, this is the height of the empty rows between bands
+		FXint h = fxBandHeight(rgn, spans, n, x0, x1, y, y1-y);
+		for (FXint i = 0; i < n; i += 2)
+			cairo_rectangle(cc, spans[i], y, spans[i+1]-spans[i], h);
+		y += h;
+	}
+	FXFREE(&spans);
+}
+
+#endif
+
+
 // Set clip region
 void FXDCCairo::setClipRegion(const FXRegion& region)
 {
+	INSTRUMENT(SET_CLIP_REGION);
 	if(!cc) {
 		fxerror("FXDCCairo::setClipRegion: DC not connected to drawable.\n");
 	}
-/*FIXME
-	Punt on this one for now.  'Region' is a construct for rectangle mathematics.  Need a
-	function to turn FXRegion into a path, which can be added using cairo_clip().
-	Cairo actually has functions for this, but whether it is worth doing...?
-	
-	XSetRegion(DISPLAY(getApp()),(GC)ctx,(Region)region.region);///// Should intersect region and rect??
-#ifdef HAVE_XFT_H
-	XftDrawSetClip((XftDraw*)xftDraw,(Region)region.region);
+	FXbool cached = fxSharedCaches();
+#ifndef WIN32
+	Region rgn = (Region)region.region;
+	XRectangle box;
+	XClipBox(rgn, &box);
+	FXCairoPathCache::Key key = { NULL, &box, sizeof(box), rgn };
+#else
+	DWORD size = GetRegionData((HRGN)region.region, 0, NULL);
+	RGNDATA * r;
+	FXMALLOC(&r, FXuchar, size);
+	GetRegionData((HRGN)region.region, size, r);
+	const RECT * rects = (const RECT *)r->Buffer;
+	FXCairoPathCache::Key key = { NULL, rects, (FXuint)(r->rdh.nCount*sizeof(RECT)), NULL };
 #endif
-	flags|=GCClipMask;
-*/
+	cairo_path_t * path = cached ? clipPaths.lookup(key) : NULL;
+	cairo_new_path(cc);
+	if (path)
+		cairo_append_path(cc, path);
+	else {
+#ifndef WIN32
+		fxPathXRegion(cc, rgn, box);
+#else
+		for (DWORD i = 0; i < r->rdh.nCount; ++i)
+			cairo_rectangle(cc, rects[i].left, rects[i].top,
+				rects[i].right-rects[i].left, rects[i].bottom-rects[i].top);
+#endif
+		if (cached)
+			clipPaths.store(key, cairo_copy_path(cc));
+	}
+#ifdef WIN32
+	FXFREE(&r);
+#endif
+	// An empty region clips everything, as with FXDCWindow
+	if (cr_maskclip)
+		keepClip();
+	cairo_clip(cc);
 }
 
 
@@ -1613,6 +3356,8 @@ void FXDCCairo::setClipRectangle(FXint x,FXint y,FXint w,FXint h)
 		fxerror("FXDCCairo::setClipRectangle: DC not connected to drawable.\n");
 	}
 	cairo_rectangle(cc, x, y, w, h);
+	if (cr_maskclip)
+		keepClip();
 	cairo_clip(cc);
 }
 
@@ -1624,6 +3369,8 @@ void FXDCCairo::setClipRectangle(const FXRectangle& rectangle)
 		fxerror("FXDCCairo::setClipRectangle: DC not connected to drawable.\n");
 	}
 	cairo_rectangle(cc, rectangle.x, rectangle.y, rectangle.w, rectangle.h);
+	if (cr_maskclip)
+		keepClip();
 	cairo_clip(cc);
 }
 
@@ -1635,49 +3382,260 @@ void FXDCCairo::clearClipRectangle()
 		fxerror("FXDCCairo::clearClipRectangle: DC not connected to drawable.\n");
 	}
 	
-	cairo_reset_clip(cc);
+	if (cr_maskclip) {
+		// The mask stays, as with FXDCWindow.  The mask clip is removed and
+		// applied again, so the clip is reset outside its cairo_save().
+		freeClips();
+		removeMaskClip();
+		cairo_reset_clip(cc);
+		cairo_path_t * p = cairo_copy_path(cc);
+		cairo_save(cc);
+		cr_masksharp = sharp_offset;
+		cr_maskclip = clipToMask();
+		if (!cr_maskclip)
+			cairo_restore(cc);
+		cairo_new_path(cc);
+		cairo_append_path(cc, p);
+		cairo_path_destroy(p);
+	}
+	else
+		cairo_reset_clip(cc);
+}
+
+
+/*
+	Clip masks.
+	
+	Cairo does not model masking this way (because of its vector model).  The mask
+	is a bitmap, i.e. an A1 surface, so it can be turned into a path of rectangles
+	(runs of set pixels, merged down the rows) and used as a clip.  The clip is
+	applied inside a cairo_save() when the mask is set, and removed by a
+	cairo_restore() when it is cleared, so drawing with a mask costs no more than
+	without.  The path is cached by bitmap and content in clipPaths.
+	
+	The restore also undoes any Cairo state set since the mask was applied.  Our
+	cached state is forgotten, line cap/join and fill rule are set again, and
+	clip rectangles and regions set meanwhile are kept and applied again.
+	
+	A mask with a very large number of rectangles (e.g. dithered) is instead
+	applied with cairo_mask() at each paint, drawing into a group bounded by the
+	mask extent.
+	
+	The mask is positioned using the transform at the time of the API call.
+*/
+
+#define MASK_MAX_RECTS 4096
+
+// Forget cached Cairo state, after a cairo_restore()
+void FXDCCairo::forgetState()
+{
+	src = NONE;
+	cr_linewidth = (FXuint)-1;
+	cr_dashstyle = (FXLineStyle)-1;
+}
+
+
+// Test pixel x of a row of an A1 surface
+static inline FXbool fxA1Pixel(const FXuchar * row, FXint x)
+{
+#if FOX_BIGENDIAN
+	return (row[x>>3] & (0x80>>(x&7))) != 0;
+#else
+	return (row[x>>3] & (1<<(x&7))) != 0;
+#endif
+}
+
+
+// Add rectangles of set pixels in A1 surface to the path.  Runs of set pixels
+// in each row extend the rectangle above if they start and end at the same
+// place.  Returns FALSE if there are too many rectangles.
+static FXbool fxPathA1Rectangles(cairo_t * cc, cairo_surface_t * s, FXint w, FXint h)
+{
+	struct Run { FXint x0, x1, top; };
+	const FXuchar * data = cairo_image_surface_get_data(s);
+	FXint stride = cairo_image_surface_get_stride(s);
+	Run * open;				// Rectangles continuing down to the previous row
+	Run * next;				// ... to this row
+	FXint nopen = 0;
+	FXuint nrects = 0;
+	FXMALLOC(&open, Run, w/2+1);
+	FXMALLOC(&next, Run, w/2+1);
+	for (FXint y = 0; y <= h && nrects <= MASK_MAX_RECTS; ++y) {
+		const FXuchar * row = data + y*stride;
+		FXint nnext = 0;
+		FXint i = 0;
+		FXint x = 0;
+		while (y < h) {
+			FXint x0 = x;
+			while (x0 < w && !fxA1Pixel(row, x0))
+				++x0;
+			if (x0 >= w)
+				break;
+			FXint x1 = x0;
+			while (x1 < w && fxA1Pixel(row, x1))
+				++x1;
+			// Rectangles above which no run continues are finished
+			while (i < nopen && (open[i].x0 < x0 || (open[i].x0 == x0 && open[i].x1 != x1))) {
+				cairo_rectangle(cc, open[i].x0, open[i].top, open[i].x1-open[i].x0, y-open[i].top);
+				++nrects;
+				++i;
+			}
+			if (i < nopen && open[i].x0 == x0)
+				next[nnext++] = open[i++];
+			else {
+				next[nnext].x0 = x0;
+				next[nnext].x1 = x1;
+				next[nnext].top = y;
+				++nnext;
+			}
+			x = x1;
+		}
+		for (; i < nopen; ++i) {
+			cairo_rectangle(cc, open[i].x0, open[i].top, open[i].x1-open[i].x0, y-open[i].top);
+			++nrects;
+		}
+		Run * t = open;
+		open = next;
+		next = t;
+		nopen = nnext;
+	}
+	FXFREE(&open);
+	FXFREE(&next);
+	return nrects <= MASK_MAX_RECTS;
+}
+
+
+// Clip to the mask; returns FALSE if it is too complex to use as a clip
+FXbool FXDCCairo::clipToMask()
+{
+	FXuchar * bits = mask->getData();
+	FXCairoPathCache::Key key = { mask, bits, bits ? (FXuint)(((mask->getWidth()+7)>>3)*mask->getHeight()) : 0, NULL };
+	FXbool cached = bits && fxSharedCaches();
+	cairo_path_t * path = cached ? clipPaths.lookup(key) : NULL;
+	cairo_new_path(cc);
+	if (!path) {
+		if (!fxPathA1Rectangles(cc, ksurf, mask->getWidth(), mask->getHeight())) {
+			cairo_new_path(cc);
+			return FALSE;
+		}
+		path = cairo_copy_path(cc);
+		cairo_new_path(cc);
+		if (cached)
+			clipPaths.store(key, path);
+	}
+	cairo_translate(cc, cx, cy);
+	cairo_append_path(cc, path);
+	cairo_translate(cc, -cx, -cy);
+	if (!cached)
+		cairo_path_destroy(path);
+	cairo_clip(cc);
+	return TRUE;
+}
+
+
+// Keep copy of clip path about to be applied on top of the mask clip
+void FXDCCairo::keepClip()
+{
+	FXRESIZE(&cr_clips, cairo_path_t *, cr_nclips+1);
+	cr_clips[cr_nclips++] = cairo_copy_path(cc);
+}
+
+
+void FXDCCairo::freeClips()
+{
+	for (FXuint i = 0; i < cr_nclips; ++i)
+		cairo_path_destroy(cr_clips[i]);
+	FXFREE(&cr_clips);
+	cr_nclips = 0;
+}
+
+
+// Remove mask clip, keeping other state and the current path
+void FXDCCairo::removeMaskClip()
+{
+	cairo_path_t * p = cairo_copy_path(cc);
+	cairo_restore(cc);
+	cr_maskclip = FALSE;
+	forgetState();
+	if (sharp_offset != cr_masksharp)
+		cairo_translate(cc, sharp_offset ? 0.5 : -0.5, sharp_offset ? 0.5 : -0.5);
+	setFillRule(rule);
+	setLineCap(cap);
+	setLineJoin(join);
+	for (FXuint i = 0; i < cr_nclips; ++i) {
+		cairo_new_path(cc);
+		cairo_append_path(cc, cr_clips[i]);
+		cairo_clip(cc);
+	}
+	freeClips();
+	cairo_new_path(cc);
+	cairo_append_path(cc, p);
+	cairo_path_destroy(p);
+}
+
+
+// Start painting through a mask which is not a clip.  The group is bounded
+// by the mask extent.
+void FXDCCairo::pushMask()
+{
+	cairo_path_t * p = cairo_copy_path(cc);
+	cairo_save(cc);
+	cairo_new_path(cc);
+	cairo_rectangle(cc, cx, cy, mask->getWidth(), mask->getHeight());
+	cairo_clip(cc);
+	cairo_append_path(cc, p);
+	cairo_path_destroy(p);
+	cairo_push_group(cc);
+}
+
+
+// Finish painting through the mask
+void FXDCCairo::popMask()
+{
+	cairo_pop_group_to_source(cc);
+	cairo_mask_surface(cc, ksurf, cx, cy);
+	cairo_restore(cc);
+	forgetState();
 }
 
 
 // Set clip mask
 void FXDCCairo::setClipMask(FXBitmap* bitmap,FXint dx,FXint dy)
 {
+	INSTRUMENT(SET_CLIP_MASK);
 	if(!cc) {
 		fxerror("FXDCCairo::setClipMask: DC not connected to drawable.\n");
 	}
 	if(!bitmap) {
 		fxerror("FXDCCairo::setClipMask: illegal mask specified.\n");
 	}
-/*
-	Cairo does not model masking this way (because of its vector model).
-	What we can do is use the cairo_mask() function when we paint instead
-	of cairo_paint(), however we need a temporary surface to become the
-	source, with this surface having the contents of the current fill or
-	stroke.  Cairo helps here with cairo_push_group() etc.
-	
-	Since this is relatively inefficient, and there are better ways to
-	achieve the desired effect, this API should not be used.  Use path
-	clipping instead.
-	
-	Even worse, it will not work as expected if transforms are used, since
-	the mask location travels with the user space coords, rather than staying
-	fixed to the location (and scale) at the point of this API call.
-*/
-	if (!cr_mask || bitmap != mask) {
-		mask=bitmap;
-		cr_mask = TRUE;
+	if (cr_maskclip)
+		removeMaskClip();
+	if (!cr_mask || bitmap != mask || !ksurf) {
 		if (ksurf)
 			cairo_surface_destroy(ksurf);
 		ksurf = fxToCairoClient(bitmap);
+		if (!ksurf) {
+			fxerror("FXDCCairo::setClipMask: no client pixel buffer available.\n");
+		}
 	}
+	mask=bitmap;
+	cr_mask = TRUE;
 	cx=dx;
 	cy=dy;
+	cairo_save(cc);
+	cr_masksharp = sharp_offset;
+	cr_maskclip = clipToMask();
+	if (!cr_maskclip)
+		cairo_restore(cc);
 }
 
 
 // Clear clip mask
 void FXDCCairo::clearClipMask()
 {
+	if (cr_maskclip)
+		removeMaskClip();
 	cr_mask=FALSE;
 	cx=0;
 	cy=0;
@@ -39,6 +39,89 @@ class FXBitmap;
 class FXIcon;
 class FXFont;
 class FXVisual;
+class FXCairoDisplayList;
+class FXVectorImage;
+class FXVectorIcon;
+struct FXCairoSurfaceEntry;
+
+
+/// Statistics reported by the FXDCCairo caches
+struct FXCairoCacheStats {
+	FXuint hits;		// Lookups satisfied from the cache
+	FXuint misses;		// Lookups which had to create new objects
+	FXuint evictions;	// Entries dropped to make room, or found stale
+	FXuint entries;		// Entries currently held
+	FXuval bytes;		// Approximate client-side memory held
+};
+
+
+/// A string for FXDCCairo::drawTexts(), with its base line starting at x, y
+struct FXCairoText {
+	FXint x;
+	FXint y;
+	const FXchar * text;
+	FXuint length;
+};
+
+
+/**
+* Counts and times of FXDCCairo operations, kept when the library is
+* configured with --enable-instrument (which defines FXDCCAIRO_INSTRUMENT);
+* otherwise they stay zero.  There is one set per DC, and one for the whole
+* process.  Times are in nanoseconds and include nested operations, so for
+* example the paint() of a drawRectangle() is counted under both.
+*/
+struct FXCairoOpStats {
+	enum {
+		DRAW_POINT,
+		DRAW_POINTS,			// drawPoints(), drawPointsRel()
+		DRAW_LINE,
+		DRAW_LINES,				// drawLines(), drawLinesRel()
+		DRAW_LINE_SEGMENTS,
+		DRAW_RECTANGLE,
+		DRAW_RECTANGLES,
+		DRAW_ROUND_RECTANGLE,
+		DRAW_ARC,
+		DRAW_ARCS,
+		DRAW_ELLIPSE,
+		FILL_RECTANGLE,
+		FILL_RECTANGLES,
+		FILL_ROUND_RECTANGLE,
+		FILL_CHORD,
+		FILL_CHORDS,
+		FILL_ARC,
+		FILL_ARCS,
+		FILL_ELLIPSE,
+		FILL_POLYGON,			// All fill*Polygon*()
+		DRAW_HASH_BOX,
+		DRAW_FOCUS_RECTANGLE,
+		DRAW_AREA,
+		DRAW_IMAGE,
+		DRAW_DISPLAY_LIST,
+		DRAW_VECTOR_IMAGE,
+		DRAW_BITMAP,
+		DRAW_ICON,
+		DRAW_ICON_SHADED,
+		DRAW_ICON_SUNKEN,
+		DRAW_TEXT,
+		DRAW_TEXTS,
+		DRAW_IMAGE_TEXT,
+		SET_CLIP_REGION,
+		SET_CLIP_MASK,
+		READ_PIXEL,
+		PAINT,					// Cairo stroke and fill
+		PAINT_TEXT,				// Pango rendering
+		TEXT_LAYOUT,			// Pango layout (cached or shaped)
+		CONVERT,				// Image, bitmap and stipple to Cairo conversion
+		ICON_SURFACE,			// Pre-drawing of icon variants
+		SERVER_SURFACE,			// Xlib (or Win32) surface creation
+		UPDATE_TRANSFORM,		// Reading back the transformation after a change
+		MEASURE_TEXT,			// Text extents from the layout cache
+		LAST
+	};
+	FXuint count[LAST];
+	FXTime time[LAST];
+};
 
 
 /**
@@ -71,13 +154,13 @@ class FXVisual;
 * or non-implementation:
 *  Aything to do with FXBitmap or FXIcon e.g. stipple, drawIcon etc.
 *  setFunction() - raster ops are a hack for bit planes - not implemented
-*  setClipRegion() - don't implement region math
-*  setClipMask() - uses bitmask
+*  setClipRegion() - intersects with the current clip, rather than replacing it
+*  setClipMask() - fine for simple shapes; dithered masks are slow
 *  clipChildren() - too low-level, not implemented.  Always clips child windows.
 *  readPixel(), drawPoint() - pixel things are bad at the best of times.
 *  setLineStyle() - double-dash works, but is inefficient in this class.
-*  setFillStyle() - stippling is to be avoided.  Try to use alpha blending,
-*      or use tiling instead of opaque stipple.
+*  setFillStyle() - stipples are device pixel patterns, so do not scale
+*      nicely.  Try to use alpha blending instead.
 * We really need an FXVectorImage and FXVectorIcon class to complement the
 * pixel versions.  For now, it is best to keep the client-side data if possible
 * by using the IMAGE_KEEP option.  Otherwise, it tries to get the data back from
@@ -101,8 +184,12 @@ protected:
 	cairo_surface_t * tsurf;	  // Cached tile surface
 	cairo_surface_t * ssurf;	  // Cached stipple surface
 	cairo_surface_t * ksurf;	  // Cached clip mask surface (A1 or A8)
-	PangoFontDescription * pfd;   // Cached Pango objects
+	PangoFontDescription * pfd;   // Description of font (see cr_ownpfd)
 	PangoLayout * layout;
+	PangoLayout * tlayout;		  // Layout of text being drawn (layout or cached)
+	cairo_path_t ** cr_clips;	  // Clips set while the mask clip is applied
+	FXCairoSurfaceEntry * centry; // Surface cache entry (NULL if not cached)
+	cairo_matrix_t cr_ctm;		  // Copy of the transformation (if cr_xform)
 #else
 	// Avoid any header dependency for application code
 	void * cc;
@@ -112,6 +199,10 @@ protected:
 	void * ksurf;
 	void * pfd;
 	void * layout;
+	void * tlayout;
+	void ** cr_clips;
+	void * centry;
+	double cr_ctm[6];
 #endif
 	enum {
 		NONE,
@@ -128,20 +219,68 @@ protected:
 	FXbool sharp_offset;
 	FXFillStyle cr_fillstyle;
 	FXImage * cr_tile;
+	FXBitmap * cr_stipple;		  // Stipple in ssurf (NULL if built-in pattern)
+	FXStipplePattern cr_pattern;
+	FXColor cr_sfg;				  // Colours of ssurf
+	FXColor cr_sbg;
 	double cr_tx;
 	double cr_ty;
 	FXbool cr_mask;
+	FXbool cr_maskclip;			  // Mask applied as clip path (inside a cairo_save())
+	FXbool cr_masksharp;		  // sharp_offset when the mask clip was applied
+	FXuint cr_nclips;
 	double cr_cx;
 	double cr_cy;
 	FXbool do_sharpen;
+	FXFont * cr_font;			  // Font described by pfd
+	FXbool cr_ownpfd;			  // pfd belongs to the DC, not the font cache
+	FXCairoOpStats * opstats;	  // NULL if not instrumented
+	FXuint cr_xform;			  // XFORM_* flags for cr_ctm, 0 if not known
+	double cr_pixw;				  // Device pixel size in user space
+	double cr_pixh;
+	
+	enum {
+		XFORM_KNOWN	= 1,		  // cr_ctm, cr_pixw and cr_pixh are up to date
+		XFORM_AXIS	= 2,		  // No rotation or shear
+		XFORM_UNIT	= 4			  // ... and no scale
+	};
 	
 	virtual void * createServerSurface(const FXDrawable * d);
+	void * createClientSurface(const FXDrawable * d);
+	void * createSourceSurface(const FXDrawable * d);
+	virtual void * useRecording(void * recording);
+	void * createIconSurface(const FXIcon * icon, FXuint kind);
+	void paintIcon(const FXIcon * icon, FXuint kind, FXint dx, FXint dy);
+	void paintIconSunken(const FXIcon * icon, void * m, FXint dx, FXint dy);
+	void paintScaled(void * source, double sx, double sy, FXint dx, FXint dy, FXint dw, FXint dh, FXbool smooth);
+	void beginSurface(void * target);
+	void resetState();
+	void updateTransform();
+	// Must be called after changing the transformation other than inside a
+	// cairo_save() / cairo_restore() pair
+	void transformChanged() { cr_xform = 0; }
+	FXuint transformFlags() { if (!cr_xform) updateTransform(); return cr_xform; }
 	void sharpOffset(FXbool on);
 	void setSourceRGBA(FXColor clr);
 	void setSourceTile();
+	void setSourceStipple(FXbool opaque);
 	virtual void setSource(FXbool alternative = FALSE);
 	virtual void paint(FXbool stroke=TRUE, FXbool fill=FALSE, FXbool preserve=FALSE);
+	void setTextLayout(const FXchar* string, FXuint length);
 	virtual void paintTextLayout(double x, double y, FXbool fillbg=FALSE);
+	FXbool pixelAligned();
+	void resetFillRule();
+	FXbool opaqueSource(FXbool stroke);
+	FXbool pointSquare(double & ox, double & oy, double & xx, double & yy);
+	void fillPoints(const FXPoint* points,FXuint npoints,FXbool relative);
+	void forgetState();
+	FXbool copyAreaServer(const FXDrawable* source,FXint sx,FXint sy,FXint sw,FXint sh,FXint dx,FXint dy);
+	FXbool clipToMask();
+	void keepClip();
+	void freeClips();
+	void removeMaskClip();
+	void pushMask();
+	void popMask();
 	
 	// Some path construction methods to emulate FXDCWindow semantics...
 	
@@ -152,6 +291,8 @@ protected:
 	// arc is exactly 360 degrees. (Note that units are still in Xlib style 1/64 degree).
 	virtual void pathArc(FXint x,FXint y,FXint w,FXint h,FXint ang1,FXint ang2, 
 					FXbool pie=FALSE,FXbool for_stroke=TRUE);
+	// Fill arcs (pies if pie is true, else chords), in one paint where possible
+	void paintArcs(const FXArc* arcs,FXuint narcs,FXbool pie);
 	// Add path of rounded rectangle with ellipse with ew and ellipse height eh and pointiness
 	// factor F (F=0.6 for roughly circular/elliptical)
 	virtual void pathRoundRectangle(FXint x,FXint y,FXint w,FXint h,FXint ew,FXint eh,FXfloat F);
@@ -159,6 +300,11 @@ protected:
 
 
 
+	/// Construct for drawing on a Cairo surface (cairo_surface_t *), which the DC
+	/// keeps a reference to.  FXDCWindow must be constructed on a created drawable:
+	/// the proxy (e.g. the root window) is used for that and nothing else.
+	FXDCCairo(FXDrawable* proxy,void* target);
+
 private:
 	FXDCCairo();
 	FXDCCairo(const FXDCCairo&);
@@ -253,11 +399,22 @@ public:
 	/// Draw image
 	virtual void drawImage(const FXImage* image,FXint dx,FXint dy);
 
+	/// Draw a recorded display list, with its origin at dx,dy
+	void drawDisplayList(const FXCairoDisplayList& list,FXint dx=0,FXint dy=0);
+
+	/// Draw vector image at its natural size, or scaled to dw*dh
+	void drawVectorImage(const FXVectorImage* image,FXint dx,FXint dy);
+	void drawVectorImage(const FXVectorImage* image,FXint dx,FXint dy,FXint dw,FXint dh);
+
 	/// Draw bitmap
 	virtual void drawBitmap(const FXBitmap* bitmap,FXint dx,FXint dy);
 
 	/// Draw icon
 	virtual void drawIcon(const FXIcon* icon,FXint dx,FXint dy);
+
+	/// Draw vector icon at its default size, or with its larger dimension size
+	void drawIcon(const FXVectorIcon* icon,FXint dx,FXint dy);
+	void drawIcon(const FXVectorIcon* icon,FXint dx,FXint dy,FXint size);
 	virtual void drawIconShaded(const FXIcon* icon,FXint dx,FXint dy);
 	virtual void drawIconSunken(const FXIcon* icon,FXint dx,FXint dy);
 
@@ -269,6 +426,36 @@ public:
 	virtual void drawImageText(FXint x,FXint y,const FXString& string);
 	virtual void drawImageText(FXint x,FXint y,const FXchar* string,FXuint length);
 
+	/// Draw many strings in the current font and colour, as drawText() would
+	/// draw each of them, but with the Cairo state set up once for all
+	virtual void drawTexts(const FXCairoText* texts,FXuint ntexts);
+
+	/// Measure text in the current font as drawText() draws it: the logical
+	/// width and height, and the distance from the top to the baseline
+	void getTextExtents(const FXchar* string,FXuint length,FXint& width,FXint& height,FXint& baseline) const;
+
+	/// Width and height of text in the current font
+	FXint getTextWidth(const FXchar* string,FXuint length) const;
+	FXint getTextWidth(const FXString& string) const;
+	FXint getTextHeight(const FXchar* string,FXuint length) const;
+	FXint getTextHeight(const FXString& string) const;
+
+	/// Measure text in font with Pango, as FXDCCairo draws it, rather than
+	/// with FXFont::getTextWidth() etc., which may not agree.  No DC is needed,
+	/// and the font need not be created.  The text is shaped once, and the
+	/// layout kept for drawing it.
+	static void getTextExtents(const FXFont* font,const FXchar* string,FXuint length,
+				FXint& width,FXint& height,FXint& baseline);
+	static FXint getTextWidth(const FXFont* font,const FXchar* string,FXuint length);
+	static FXint getTextWidth(const FXFont* font,const FXString& string);
+	static FXint getTextHeight(const FXFont* font,const FXchar* string,FXuint length);
+	static FXint getTextHeight(const FXFont* font,const FXString& string);
+
+	/// Font ascent, descent and height (ascent plus descent) according to Pango
+	static FXint getFontAscent(const FXFont* font);
+	static FXint getFontDescent(const FXFont* font);
+	static FXint getFontHeight(const FXFont* font);
+
 	/// Set foreground/background drawing color
 	virtual void setForeground(FXColor clr);
 	virtual void setBackground(FXColor clr);
@@ -307,7 +494,8 @@ public:
 	/// Set the stipple pattern
 	virtual void setStipple(FXStipplePattern stipple,FXint dx=0,FXint dy=0);
 
-	/// Set clip region.  Not implemented.
+	/// Set clip region.  Like setClipRectangle(), this intersects with the
+	/// current clip.
 	virtual void setClipRegion(const FXRegion& region);
 
 	/// Set clip rectangle
@@ -351,6 +539,127 @@ public:
 	/// adds some overhead, requires the line width to be known while generating the path,
 	/// and does not help with non-identity transforms.
 	void setLineSharpen(FXbool on = TRUE) { do_sharpen = on; }
+
+	/// The Cairo surface, context and Pango layout made for a drawable are kept
+	/// in a small per-process cache, so that repeated expose events on the same
+	/// window do not need to recreate them.  Entries are keyed by the drawable and
+	/// its id, and are replaced automatically if the drawable is resized or
+	/// re-created.  A destroyed window's entry is dropped the next time a surface
+	/// is cached; for other drawables (e.g. FXImage), call releaseSurface() when
+	/// destroying one which has been painted with FXDCCairo, so that the
+	/// (server-side) surface is not kept around.  Like all the FXDCCairo caches,
+	/// this is not locked, and is for the GUI thread only.
+	static void releaseSurface(const FXDrawable * drawable);
+
+	/// Release all cached drawable surfaces which are not currently in use.
+	static void flushSurfaceCache();
+
+	/// Get hit/miss statistics for the drawable surface cache
+	static void getSurfaceCacheStats(FXCairoCacheStats & stats);
+
+	/// Reset hit/miss counters of the drawable surface cache
+	static void resetSurfaceCacheStats();
+
+	/// FXImage, FXIcon and FXBitmap pixels are converted to Cairo image surfaces
+	/// when drawn, and the results are kept in an LRU cache keyed by the object
+	/// (and the colours the conversion depends on).  The cache notices when an
+	/// object's client data pointer, size or X id changes, so a new object made
+	/// at the address of a deleted one is converted afresh once it is created.
+	/// It can't see the pixels change, so the application must call
+	/// invalidateImage() after every change to the pixels made in place (e.g.
+	/// with setPixel(), or by writing to getData()).  Calling it before deleting
+	/// an object frees the conversions straight away; for a bitmap used as a
+	/// clip mask or stipple without being created, it is needed, since such a
+	/// bitmap has no X id to tell it from a later one.
+	static void invalidateImage(const FXDrawable * image);
+
+	/// Declare that the client pixels of image are already in Cairo's format:
+	/// pre-multiplied ARGB32 (native endian 0xAARRGGBB words), as left by an
+	/// FXDCCairoImage drawing into image->getData().  The buffer is then drawn
+	/// in place, with no conversion or copy, and always from the client side
+	/// (the server side pixmap would have the colours wrong).  Call
+	/// invalidateImage() after changing the pixels.  The flag lapses if the
+	/// image's buffer or size changes, or it is destroyed or deleted.
+	static void setImagePremultiplied(const FXImage * image, FXbool premultiplied = TRUE);
+
+	/// Return TRUE if the pixels of image are pre-multiplied ARGB32
+	static FXbool isImagePremultiplied(const FXImage * image);
+
+	/// Drop the rasters of a vector image (FXVectorImage does this itself)
+	static void invalidateImage(const FXVectorImage * image);
+
+	/// Return a new reference to an ARGB32 surface (cairo_surface_t *) with
+	/// image rasterized at w*h pixels, from the image cache if it was made before
+	static void * getVectorRaster(const FXVectorImage * image, FXint w, FXint h);
+
+	/// Release all converted images
+	static void flushImageCache();
+
+	/// Set memory budget for converted images, in bytes (default 16MB)
+	static void setImageCacheBudget(FXuval bytes);
+
+	/// Get memory budget for converted images
+	static FXuval getImageCacheBudget();
+
+	/// Get statistics for the converted image cache
+	static void getImageCacheStats(FXCairoCacheStats & stats);
+
+	/// Reset hit/miss counters of the converted image cache
+	static void resetImageCacheStats();
+
+	/// Text drawn unrotated, with no scaling, is laid out (shaped) once and the
+	/// Pango layout is kept in an LRU cache keyed by the font and the text, so
+	/// labels drawn on every repaint are not reshaped.  Release all cached layouts.
+	static void flushLayoutCache();
+
+	/// Set the (estimated) memory budget for cached layouts, in bytes (default 4MB)
+	static void setLayoutCacheBudget(FXuval bytes);
+
+	/// Get the memory budget for cached layouts
+	static FXuval getLayoutCacheBudget();
+
+	/// Get statistics for the layout cache
+	static void getLayoutCacheStats(FXCairoCacheStats & stats);
+
+	/// Reset hit/miss counters of the layout cache
+	static void resetLayoutCacheStats();
+
+	/// Pango font descriptions are made once for each FXFont and kept in a cache
+	/// shared by all DC's, which notices when the font's attributes change.
+	/// Release all cached descriptions.  Not while a DC is drawing.
+	static void flushFontCache();
+
+	/// Drop the cached description of a font, e.g. before deleting it.  Not
+	/// while a DC is drawing with it.
+	static void invalidateFont(const FXFont * font);
+
+	/// Get statistics for the font cache
+	static void getFontCacheStats(FXCairoCacheStats & stats);
+
+	/// Reset hit/miss counters of the font cache
+	static void resetFontCacheStats();
+
+	/// Return TRUE if the library keeps operation counts (see FXCairoOpStats)
+	static FXbool isInstrumented();
+
+	/// Get the operation counts of this DC, since it was made or reset
+	void getOpStats(FXCairoOpStats & stats) const;
+
+	/// Reset the operation counts of this DC
+	void resetOpStats();
+
+	/// Get the operation counts of all DC's in the process
+	static void getGlobalOpStats(FXCairoOpStats & stats);
+
+	/// Reset the process operation counts
+	static void resetGlobalOpStats();
+
+	/// Name of operation, e.g. "drawLine"
+	static const FXchar * getOpName(FXuint op);
+
+	/// Print the operations which have been used, one per line:
+	///   <operation> <count> <total ns> <ns/op>
+	static void dumpOpStats(const FXCairoOpStats & stats, FILE * fp = stderr);
 	
 };
 
@@ -0,0 +1,165 @@
+/********************************************************************************
+*                                                                               *
+*              C a i r o   I m a g e   D e v i c e   C o n t e x t              *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2013 by Stephen J. Hardy.   All Rights Reserved.                *
+*********************************************************************************
+* This library is free software; you can redistribute it and/or                 *
+* modify it under the terms of the GNU Lesser General Public                    *
+* License as published by the Free Software Foundation; either                  *
+* version 2.1 of the License, or (at your option) any later version.            *
+*                                                                               *
+* This library is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU             *
+* Lesser General Public License for more details.                               *
+*                                                                               *
+* You should have received a copy of the GNU Lesser General Public              *
+* License along with this library; if not, write to the Free Software           *
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.    *
+*********************************************************************************
+* $Id: $                     *
+********************************************************************************/
+
+#include "xincs.h"
+#include "fxver.h"
+#include "fxdefs.h"
+#include "FXHash.h"
+#include "FXThread.h"
+#include "FXStream.h"
+#include "FXString.h"
+#include "FXPoint.h"
+#include "FXRectangle.h"
+#include "FXRegistry.h"
+#include "FXApp.h"
+#include "FXId.h"
+#include "FXDrawable.h"
+#include "FXWindow.h"
+#include "FXDC.h"
+#include "FXDCWindow.h"
+
+#include "xincs_cairo.h"
+
+#include "config.h"
+#include "FXDCCairo.h"
+#include "FXDCCairoImage.h"
+#include "FXCairoPixels.h"
+
+
+/*
+  Notes:
+  - FXDCCairo does all the drawing; this just sets it up on an image surface
+    and replaces the parts which would otherwise read from the X server.
+  - The caller's buffer is wrapped with cairo_image_surface_create_for_data(),
+    so the DC owns the surface but not the pixels.
+*/
+
+using namespace FX;
+
+namespace FX
+{
+
+
+// Wrap caller's buffer
+void * FXDCCairoImage::createTarget(FXuchar * data, FXint w, FXint h, FXint stride)
+{
+	if(!data || w <= 0 || h <= 0) {
+		fxerror("FXDCCairoImage: illegal buffer specified.\n");
+	}
+	cairo_surface_t * s = cairo_image_surface_create_for_data(data, CAIRO_FORMAT_ARGB32, w, h, stride);
+	if (cairo_surface_status(s) != CAIRO_STATUS_SUCCESS) {
+		fxerror("FXDCCairoImage: invalid stride for buffer.\n");
+	}
+	return s;
+}
+
+
+// Check caller's surface is one we can read back
+void * FXDCCairoImage::checkTarget(void * surface)
+{
+	cairo_surface_t * s = (cairo_surface_t *)surface;
+	if(!s || cairo_surface_get_type(s) != CAIRO_SURFACE_TYPE_IMAGE ||
+	   (cairo_image_surface_get_format(s) != CAIRO_FORMAT_ARGB32 &&
+	    cairo_image_surface_get_format(s) != CAIRO_FORMAT_RGB24)) {
+		fxerror("FXDCCairoImage: surface must be an ARGB32 or RGB24 image surface.\n");
+	}
+	return s;
+}
+
+
+// Construct for drawing into caller's buffer
+FXDCCairoImage::FXDCCairoImage(FXApp* app,FXuchar* data,FXint w,FXint h,FXint stride):
+	FXDCCairo(app->getRootWindow(), createTarget(data, w, h, stride))
+{
+	cairo_surface_destroy(csurf);	// Drop reference from createTarget(); DC has its own
+	pixels = data;
+	width = w;
+	height = h;
+	this->stride = stride;
+	opaque = FALSE;
+}
+
+
+// Construct for drawing on caller's image surface
+FXDCCairoImage::FXDCCairoImage(FXApp* app,void* surface):
+	FXDCCairo(app->getRootWindow(), checkTarget(surface))
+{
+	pixels = cairo_image_surface_get_data(csurf);
+	width = cairo_image_surface_get_width(csurf);
+	height = cairo_image_surface_get_height(csurf);
+	stride = cairo_image_surface_get_stride(csurf);
+	opaque = cairo_image_surface_get_format(csurf) == CAIRO_FORMAT_RGB24;
+}
+
+
+// Stride for an ARGB32 buffer
+FXint FXDCCairoImage::getStride(FXint w)
+{
+	return cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32, w);
+}
+
+
+// Images are drawn from their client side pixels, rather than the server
+void * FXDCCairoImage::createServerSurface(const FXDrawable * d)
+{
+	void * s = createClientSurface(d);
+	return s ? s : FXDCCairo::createServerSurface(d);
+}
+
+
+// Read back pixel from memory
+FXColor FXDCCairoImage::readPixel(FXint x,FXint y)
+{
+	double xx = x;
+	double yy = y;
+	transformFlags();
+	cairo_matrix_transform_point(&cr_ctm, &xx, &yy);
+	FXint px = (FXint)floor(xx);
+	FXint py = (FXint)floor(yy);
+	if (px < 0 || py < 0 || px >= width || py >= height)
+		return 0;
+	cairo_surface_flush(csurf);
+	FXuint p = ((const FXuint *)(pixels + py*stride))[px];
+	return fxARGB32ToColor(opaque ? p | 0xFF000000 : p);
+}
+
+
+// Copy out as FXColor
+void FXDCCairoImage::getPixels(FXColor* data)
+{
+	if(!data) {
+		fxerror("FXDCCairoImage::getPixels: NULL buffer.\n");
+	}
+	cairo_surface_flush(csurf);
+	fxCairoARGB32ToClientFXColor(height, stride, (const FXuint *)pixels,
+		width*sizeof(FXColor), data, opaque);
+}
+
+
+// Destruct; FXDCCairo releases the surface
+FXDCCairoImage::~FXDCCairoImage()
+{
+}
+
+}
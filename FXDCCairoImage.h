@@ -0,0 +1,115 @@
+/********************************************************************************
+*                                                                               *
+*              C a i r o   I m a g e   D e v i c e   C o n t e x t              *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2013 by Stephen J. Hardy.   All Rights Reserved.                *
+*********************************************************************************
+* This library is free software; you can redistribute it and/or                 *
+* modify it under the terms of the GNU Lesser General Public                    *
+* License as published by the Free Software Foundation; either                  *
+* version 2.1 of the License, or (at your option) any later version.            *
+*                                                                               *
+* This library is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU             *
+* Lesser General Public License for more details.                               *
+*                                                                               *
+* You should have received a copy of the GNU Lesser General Public              *
+* License along with this library; if not, write to the Free Software           *
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.    *
+*********************************************************************************
+* $Id: $                        *
+********************************************************************************/
+#ifndef FXDCCAIROIMAGE_H
+#define FXDCCAIROIMAGE_H
+
+#ifndef FXDCCAIRO_H
+#include "FXDCCairo.h"
+#endif
+
+namespace FX
+{
+
+
+/**
+* Cairo device context which draws into memory instead of a window.
+*
+* The target is either a pixel buffer owned by the caller, in Cairo's ARGB32
+* format (native endian 0xAARRGGBB words with the colour pre-multiplied by
+* alpha, stride bytes per row), or a Cairo image surface.  Drawing does not go
+* through the X server, so it is suitable for rendering many small images
+* (thumbnails, charts for reports) in batch code.  When the DC is destroyed,
+* the buffer holds the finished image, ready to be encoded.
+*
+* FOX requires an FXDCWindow to be made on a created drawable, so the
+* application must still be created on a display (Xvfb will do on a machine
+* with no screen).  The root window is used for that, and nothing is drawn
+* on it.  Images, icons and tiles drawn on this DC are taken from their
+* client-side pixels (so create them with IMAGE_KEEP), only falling back to
+* the server if they have none.
+*
+* Apart from that, the FXDC API behaves just as for FXDCCairo.
+*
+* The DC may be made and used on a worker thread, one DC per thread.  The
+* caches FXDCCairo shares between DCs (converted images, fonts, text layouts,
+* clip paths) belong to the main thread, so a DC on another thread does its
+* own conversions each time, and is slower at drawing images and text.  The
+* application must not change or delete an image, icon or font while a worker
+* draws with it.  The static FXDCCairo functions (text measurement, cache
+* control, releaseSurface()) and setImagePremultiplied() are for the main
+* thread only.  In an instrumented build, a worker's DC counts its own
+* operations (getOpStats()), but they are left out of the process totals.
+*/
+class FXAPI FXDCCairoImage : public FXDCCairo
+{
+protected:
+	FXuchar * pixels;
+	FXint width;
+	FXint height;
+	FXint stride;
+	FXbool opaque;		// RGB24 target
+
+	virtual void * createServerSurface(const FXDrawable * d);
+
+	static void * createTarget(FXuchar * data, FXint w, FXint h, FXint stride);
+	static void * checkTarget(void * surface);
+
+private:
+	FXDCCairoImage();
+	FXDCCairoImage(const FXDCCairoImage&);
+	FXDCCairoImage &operator=(const FXDCCairoImage&);
+public:
+
+	/// Construct for drawing into an ARGB32 buffer of w*h pixels with the
+	/// given stride in bytes (see getStride()).  The buffer is not cleared.
+	FXDCCairoImage(FXApp* app,FXuchar* data,FXint w,FXint h,FXint stride);
+
+	/// Construct for drawing on a Cairo image surface (cairo_surface_t *) in
+	/// ARGB32 or RGB24 format.  The DC keeps its own reference until destroyed.
+	FXDCCairoImage(FXApp* app,void* surface);
+
+	/// Return the stride in bytes Cairo wants for an ARGB32 buffer w pixels wide
+	static FXint getStride(FXint w);
+
+	/// Size of target
+	FXint getWidth() const { return width; }
+	FXint getHeight() const { return height; }
+
+	/// Target surface (cairo_surface_t *)
+	void * getSurface() const { return csurf; }
+
+	/// Read back pixel
+	virtual FXColor readPixel(FXint x,FXint y);
+
+	/// Copy what has been drawn so far into w*h FXColor pixels (not
+	/// pre-multiplied), e.g. for saving with fxsavePNG()
+	void getPixels(FXColor* data);
+
+	/// Destructor
+	virtual ~FXDCCairoImage();
+};
+
+}
+
+#endif
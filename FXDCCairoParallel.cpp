@@ -0,0 +1,246 @@
+/********************************************************************************
+*                                                                               *
+*           P a r a l l e l   C a i r o   D e v i c e   C o n t e x t           *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2013 by Stephen J. Hardy.   All Rights Reserved.                *
+*********************************************************************************
+* This library is free software; you can redistribute it and/or                 *
+* modify it under the terms of the GNU Lesser General Public                    *
+* License as published by the Free Software Foundation; either                  *
+* version 2.1 of the License, or (at your option) any later version.            *
+*                                                                               *
+* This library is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU             *
+* Lesser General Public License for more details.                               *
+*                                                                               *
+* You should have received a copy of the GNU Lesser General Public              *
+* License along with this library; if not, write to the Free Software           *
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.    *
+*********************************************************************************
+* $Id: $                     *
+********************************************************************************/
+
+#include "xincs.h"
+#include "fxver.h"
+#include "fxdefs.h"
+#include "FXHash.h"
+#include "FXThread.h"
+#include "FXStream.h"
+#include "FXString.h"
+#include "FXPoint.h"
+#include "FXRectangle.h"
+#include "FXRegistry.h"
+#include "FXApp.h"
+#include "FXId.h"
+#include "FXDrawable.h"
+#include "FXDC.h"
+#include "FXDCWindow.h"
+
+#include "xincs_cairo.h"
+
+#include "config.h"
+#include "FXDCCairo.h"
+#include "FXDCCairoParallel.h"
+#include "FXCairoThreadPool.h"
+
+
+/*
+  Notes:
+  - The DC draws on an unbounded recording surface.  present() replays it
+    into an ARGB32 frame image covering the paint rectangle.
+  - Each band gets its own image surface over its rows of the frame.
+  - Replaying a recording is not read-only: Cairo builds an index of its
+    commands, marks the visible ones in it, and attaches snapshots to
+    recordings used as sources.  So each band replays its own copy of the
+    recording, made on the calling thread before the workers start.  The copy
+    is a paint of a snapshot of the frame's recording; flushing the recording
+    detaches the snapshot, so the next band's copy gets a new one.
+  - Recordings drawn into the frame (display lists, vector images) would be
+    shared by the copies, so a frame using one is replayed on the calling
+    thread, as for server-side sources.  Image sources are only read.
+  - The frame image and the worker pool are kept for the next frame.  Like the
+    other FXDCCairo caches, this is only used from the GUI thread.
+*/
+
+#define MIN_BAND_HEIGHT 16
+
+using namespace FX;
+
+namespace FX
+{
+
+
+static FXCairoThreadPool * pool = NULL;
+static FXuint poolThreads = 0;
+static cairo_surface_t * frame = NULL;
+
+
+// Replay job for one frame
+struct FXCairoBandJob {
+	cairo_surface_t ** recordings;	// Copy of the recording for each band
+	FXuchar * data;
+	FXint stride;
+	FXint x;
+	FXint y;
+	FXint w;
+	FXint h;
+	FXuint bands;
+};
+
+
+// Clear and replay rows of band i
+static void fxReplayBand(void * arg, FXuint i)
+{
+	const FXCairoBandJob * job = (const FXCairoBandJob *)arg;
+	FXint y0 = job->h*i/job->bands;
+	FXint y1 = job->h*(i+1)/job->bands;
+	FXuchar * data = job->data + y0*job->stride;
+	memset(data, 0, (y1-y0)*job->stride);
+	cairo_surface_t * s = cairo_image_surface_create_for_data(data, CAIRO_FORMAT_ARGB32,
+		job->w, y1-y0, job->stride);
+	cairo_t * cr = cairo_create(s);
+	cairo_set_source_surface(cr, job->recordings[i], -job->x, -(job->y + y0));
+	cairo_paint(cr);
+	cairo_destroy(cr);
+	cairo_surface_flush(s);
+	cairo_surface_destroy(s);
+}
+
+
+// New recording surface
+void * FXDCCairoParallel::createRecording()
+{
+	return cairo_recording_surface_create(CAIRO_CONTENT_COLOR_ALPHA, NULL);
+}
+
+
+// Construct for expose event painting
+FXDCCairoParallel::FXDCCairoParallel(FXDrawable* drawable,FXEvent* event):
+	FXDCCairo(drawable, createRecording()),
+	serial(FALSE),
+	presented(FALSE)
+{
+	cairo_surface_destroy(csurf);	// Drop reference from createRecording(); DC has its own
+	rect = event->rect;
+	cairo_rectangle(cc, rect.x, rect.y, rect.w, rect.h);
+	cairo_clip(cc);
+}
+
+
+// Construct for normal painting
+FXDCCairoParallel::FXDCCairoParallel(FXDrawable* drawable):
+	FXDCCairo(drawable, createRecording()),
+	serial(FALSE),
+	presented(FALSE)
+{
+	cairo_surface_destroy(csurf);
+	cairo_rectangle(cc, rect.x, rect.y, rect.w, rect.h);
+	cairo_clip(cc);
+}
+
+
+// Prefer client side pixels, which the workers can read
+void * FXDCCairoParallel::createServerSurface(const FXDrawable * d)
+{
+	void * s = createClientSurface(d);
+	if (s)
+		return s;
+	serial = TRUE;
+	return FXDCCairo::createServerSurface(d);
+}
+
+
+// Recordings drawn into the frame are shared with other frames
+void * FXDCCairoParallel::useRecording(void * recording)
+{
+	serial = TRUE;
+	return FXDCCairo::useRecording(recording);
+}
+
+
+// Set number of replay threads
+void FXDCCairoParallel::setThreads(FXuint n)
+{
+	if (n != poolThreads) {
+		delete pool;
+		pool = NULL;
+		poolThreads = n;
+	}
+}
+
+
+// Get number of replay threads
+FXuint FXDCCairoParallel::getThreads()
+{
+	return poolThreads ? poolThreads : FXCairoThreadPool::processors();
+}
+
+
+// Replay into the frame image, and draw that on the drawable
+void FXDCCairoParallel::present()
+{
+	if (presented)
+		return;
+	presented = TRUE;
+	if (rect.w <= 0 || rect.h <= 0)
+		return;
+	cairo_surface_flush(csurf);
+
+	if (!frame || cairo_image_surface_get_width(frame) != rect.w ||
+	    cairo_image_surface_get_height(frame) != rect.h) {
+		if (frame) cairo_surface_destroy(frame);
+		frame = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, rect.w, rect.h);
+	}
+	FXCairoBandJob job;
+	job.recordings = &csurf;
+	job.data = cairo_image_surface_get_data(frame);
+	job.stride = cairo_image_surface_get_stride(frame);
+	job.x = rect.x;
+	job.y = rect.y;
+	job.w = rect.w;
+	job.h = rect.h;
+	job.bands = FXMIN(getThreads(), (FXuint)FXMAX(rect.h/MIN_BAND_HEIGHT, 1));
+	cairo_surface_flush(frame);
+	if (serial || job.bands < 2) {
+		job.bands = 1;
+		fxReplayBand(&job, 0);
+	}
+	else {
+		FXMALLOC(&job.recordings, cairo_surface_t *, job.bands);
+		for (FXuint i = 0; i < job.bands; ++i) {
+			job.recordings[i] = cairo_recording_surface_create(CAIRO_CONTENT_COLOR_ALPHA, NULL);
+			cairo_t * cr = cairo_create(job.recordings[i]);
+			cairo_set_source_surface(cr, csurf, 0, 0);
+			cairo_paint(cr);
+			cairo_destroy(cr);
+			cairo_surface_flush(csurf);
+		}
+		if (!pool)
+			pool = new FXCairoThreadPool(poolThreads);
+		pool->execute(fxReplayBand, &job, job.bands);
+		for (FXuint i = 0; i < job.bands; ++i)
+			cairo_surface_destroy(job.recordings[i]);
+		FXFREE(&job.recordings);
+	}
+	cairo_surface_mark_dirty(frame);
+
+	cairo_surface_t * ws = (cairo_surface_t *)FXDCCairo::createServerSurface(surface);
+	cairo_t * wc = cairo_create(ws);
+	cairo_set_source_surface(wc, frame, rect.x, rect.y);
+	cairo_rectangle(wc, rect.x, rect.y, rect.w, rect.h);
+	cairo_fill(wc);
+	cairo_destroy(wc);
+	cairo_surface_flush(ws);
+	cairo_surface_destroy(ws);
+}
+
+
+// Destruct; show the frame if not done yet
+FXDCCairoParallel::~FXDCCairoParallel()
+{
+	present();
+}
+
+}
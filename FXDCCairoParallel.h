@@ -0,0 +1,100 @@
+/********************************************************************************
+*                                                                               *
+*           P a r a l l e l   C a i r o   D e v i c e   C o n t e x t           *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2013 by Stephen J. Hardy.   All Rights Reserved.                *
+*********************************************************************************
+* This library is free software; you can redistribute it and/or                 *
+* modify it under the terms of the GNU Lesser General Public                    *
+* License as published by the Free Software Foundation; either                  *
+* version 2.1 of the License, or (at your option) any later version.            *
+*                                                                               *
+* This library is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU             *
+* Lesser General Public License for more details.                               *
+*                                                                               *
+* You should have received a copy of the GNU Lesser General Public              *
+* License along with this library; if not, write to the Free Software           *
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.    *
+*********************************************************************************
+* $Id: $                        *
+********************************************************************************/
+#ifndef FXDCCAIROPARALLEL_H
+#define FXDCCAIROPARALLEL_H
+
+#ifndef FXDCCAIRO_H
+#include "FXDCCairo.h"
+#endif
+
+namespace FX
+{
+
+
+/**
+* Cairo device context which renders a frame on several threads.
+*
+* Drawing is recorded rather than done straight away.  When the DC is
+* destroyed (or present() is called) the recording is replayed into an
+* off-screen image in horizontal bands, one band per thread of a shared
+* worker pool, and the image is then drawn on the drawable in one go.
+* This pays off for large drawables (4K monitors, wall displays) with a lot
+* of anti-aliased drawing; for small ones, it only adds the cost of the copy.
+*
+* Since the image starts out transparent and is drawn over the drawable,
+* frames should paint their whole area, as a normal repaint does.  Drawing
+* which depends on the existing pixels (e.g. the sunken icon's luminosity
+* blend) is done against the transparent image instead.  readPixel() reads
+* the drawable, so does not see drawing which has not been presented.
+*
+* Images, icons and tiles are drawn from their client-side pixels (create
+* them with IMAGE_KEEP).  If a frame has to use a server-side source, it is
+* replayed on the calling thread, since Xlib must not be used from the workers.
+* So is a frame which draws a display list or the recording of a vector image,
+* since those are shared with other frames and Cairo is not free to replay
+* one on several threads at once.
+*/
+class FXAPI FXDCCairoParallel : public FXDCCairo
+{
+protected:
+	FXbool serial;		// Frame uses server side sources
+	FXbool presented;
+
+	virtual void * createServerSurface(const FXDrawable * d);
+	virtual void * useRecording(void * recording);
+
+	static void * createRecording();
+
+private:
+	FXDCCairoParallel();
+	FXDCCairoParallel(const FXDCCairoParallel&);
+	FXDCCairoParallel &operator=(const FXDCCairoParallel&);
+public:
+
+	/// Construct for painting in response to expose;
+	/// This sets the clip rectangle to the exposed rectangle
+	FXDCCairoParallel(FXDrawable* drawable,FXEvent* event);
+
+	/// Construct for normal drawing;
+	/// This sets clip rectangle to the whole drawable
+	FXDCCairoParallel(FXDrawable* drawable);
+
+	/// Replay what has been drawn and show it on the drawable.  Called by the
+	/// destructor if not called before; drawing after this is not shown.
+	void present();
+
+	/// Set number of threads used for replaying (including the GUI thread).
+	/// Zero, the default, means the number of processors.
+	static void setThreads(FXuint n);
+
+	/// Get number of threads used for replaying
+	static FXuint getThreads();
+
+	/// Destructor
+	virtual ~FXDCCairoParallel();
+};
+
+}
+
+#endif
@@ -0,0 +1,294 @@
+/********************************************************************************
+*                                                                               *
+*                        V e c t o r   I m a g e                                *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2013 by Stephen J. Hardy.   All Rights Reserved.                *
+*********************************************************************************
+* This library is free software; you can redistribute it and/or                 *
+* modify it under the terms of the GNU Lesser General Public                    *
+* License as published by the Free Software Foundation; either                  *
+* version 2.1 of the License, or (at your option) any later version.            *
+*                                                                               *
+* This library is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU             *
+* Lesser General Public License for more details.                               *
+*                                                                               *
+* You should have received a copy of the GNU Lesser General Public              *
+* License along with this library; if not, write to the Free Software           *
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.    *
+*********************************************************************************
+* $Id: $                     *
+********************************************************************************/
+
+#include "xincs.h"
+#include "fxver.h"
+#include "fxdefs.h"
+#include "FXHash.h"
+#include "FXThread.h"
+#include "FXStream.h"
+#include "FXString.h"
+#include "FXPoint.h"
+#include "FXRectangle.h"
+#include "FXRegistry.h"
+#include "FXApp.h"
+#include "FXId.h"
+#include "FXDrawable.h"
+#include "FXImage.h"
+#include "FXDC.h"
+#include "FXDCWindow.h"
+
+#include "xincs_cairo.h"
+
+#include "config.h"
+#ifdef HAVE_RSVG
+#include <librsvg/rsvg.h>
+#endif
+#include "FXDCCairo.h"
+#include "FXCairoDisplayList.h"
+#include "FXCairoPixels.h"
+#include "FXVectorImage.h"
+
+
+/*
+  Notes:
+  - An SVG is parsed once, and rendered by librsvg into a recording surface
+    bounded to its natural size; the librsvg handle (and its DOM) is then freed.
+    Rasterizing replays the recording, scaled, so there is no loss of quality
+    at large sizes.
+  - FXVectorIcon only asks for rasters at the sizes of its ladder, so a few
+    entries in the cache cover every size it is drawn at.
+  - Rasters are not kept here, but in FXDCCairo's image cache under the image
+    (see FXDCCairo::getVectorRaster()), which is told whenever the recording
+    is replaced.
+*/
+
+using namespace FX;
+
+namespace FX
+{
+
+
+// Construct empty image
+FXVectorImage::FXVectorImage():
+	recording(NULL),
+	width(0.),
+	height(0.)
+{
+}
+
+
+// Construct from SVG data
+FXVectorImage::FXVectorImage(const void* data,FXuval size):
+	recording(NULL),
+	width(0.),
+	height(0.)
+{
+	loadSVG(data, size);
+}
+
+
+// Replace recording (taking the reference passed), and drop old rasters
+void FXVectorImage::setRecording(void * rec, FXdouble w, FXdouble h)
+{
+	if (recording) {
+		FXDCCairo::invalidateImage(this);
+		cairo_surface_destroy((cairo_surface_t *)recording);
+	}
+	recording = rec;
+	width = rec ? w : 0.;
+	height = rec ? h : 0.;
+}
+
+
+// Can we load SVG
+FXbool FXVectorImage::canLoadSVG()
+{
+#ifdef HAVE_RSVG
+	return TRUE;
+#else
+	return FALSE;
+#endif
+}
+
+
+#ifdef HAVE_RSVG
+
+// Record what librsvg draws for handle
+static cairo_surface_t * fxRecordSVG(RsvgHandle * handle, FXdouble & w, FXdouble & h)
+{
+#if LIBRSVG_CHECK_VERSION(2,52,0)
+	// Natural size in pixels; FALSE if the document has no absolute size
+	if (!rsvg_handle_get_intrinsic_size_in_pixels(handle, &w, &h) || w <= 0. || h <= 0.)
+		return NULL;
+#else
+	RsvgDimensionData dim;
+	rsvg_handle_get_dimensions(handle, &dim);
+	if (dim.width <= 0 || dim.height <= 0)
+		return NULL;
+	w = dim.width;
+	h = dim.height;
+#endif
+	cairo_rectangle_t extents = { 0., 0., w, h };
+	cairo_surface_t * rec = cairo_recording_surface_create(CAIRO_CONTENT_COLOR_ALPHA, &extents);
+	cairo_t * cr = cairo_create(rec);
+#if LIBRSVG_CHECK_VERSION(2,52,0)
+	RsvgRectangle viewport = { 0., 0., w, h };
+	GError * err = NULL;
+	FXbool ok = rsvg_handle_render_document(handle, cr, &viewport, &err);
+	g_clear_error(&err);
+#else
+	FXbool ok = rsvg_handle_render_cairo(handle, cr);
+#endif
+	cairo_destroy(cr);
+	if (!ok || cairo_surface_status(rec) != CAIRO_STATUS_SUCCESS) {
+		cairo_surface_destroy(rec);
+		return NULL;
+	}
+	return rec;
+}
+
+#endif
+
+
+// Load SVG from memory
+FXbool FXVectorImage::loadSVG(const void* data,FXuval size)
+{
+	void * rec = NULL;
+	FXdouble w = 0., h = 0.;
+#ifdef HAVE_RSVG
+	GError * err = NULL;
+	RsvgHandle * handle = rsvg_handle_new_from_data((const guint8 *)data, size, &err);
+	if (handle) {
+		rec = fxRecordSVG(handle, w, h);
+		g_object_unref(handle);
+	}
+	g_clear_error(&err);
+#endif
+	setRecording(rec, w, h);
+	return rec != NULL;
+}
+
+
+// Load SVG file
+FXbool FXVectorImage::loadSVGFile(const FXString& filename)
+{
+	void * rec = NULL;
+	FXdouble w = 0., h = 0.;
+#ifdef HAVE_RSVG
+	GError * err = NULL;
+	RsvgHandle * handle = rsvg_handle_new_from_file(filename.text(), &err);
+	if (handle) {
+		rec = fxRecordSVG(handle, w, h);
+		g_object_unref(handle);
+	}
+	g_clear_error(&err);
+#endif
+	setRecording(rec, w, h);
+	return rec != NULL;
+}
+
+
+// Share recording of display list
+FXbool FXVectorImage::setDisplayList(const FXCairoDisplayList& list,FXdouble w,FXdouble h)
+{
+	if (!list.isValid() || w <= 0. || h <= 0.) {
+		setRecording(NULL, 0., 0.);
+		return FALSE;
+	}
+	setRecording(cairo_surface_reference((cairo_surface_t *)list.getRecording()), w, h);
+	return TRUE;
+}
+
+
+// Make empty
+void FXVectorImage::clear()
+{
+	setRecording(NULL, 0., 0.);
+}
+
+
+// Replay recording scaled to w*h pixels
+void * FXVectorImage::rasterize(FXint w,FXint h) const
+{
+	if (!recording || w <= 0 || h <= 0)
+		return NULL;
+	cairo_surface_t * s = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, w, h);
+	cairo_t * cr = cairo_create(s);
+	cairo_scale(cr, w/width, h/height);
+	cairo_set_source_surface(cr, (cairo_surface_t *)recording, 0., 0.);
+	cairo_paint(cr);
+	cairo_destroy(cr);
+	return s;
+}
+
+
+// Render into client pixels of image
+FXbool FXVectorImage::render(FXImage* image) const
+{
+	if (!image || !image->getData() || !recording)
+		return FALSE;
+	FXint w = image->getWidth();
+	FXint h = image->getHeight();
+	cairo_surface_t * s = (cairo_surface_t *)FXDCCairo::getVectorRaster(this, w, h);
+	if (!s)
+		return FALSE;
+	cairo_surface_flush(s);
+	fxCairoARGB32ToClientFXColor(h, cairo_image_surface_get_stride(s),
+		(const FXuint *)cairo_image_surface_get_data(s), w*sizeof(FXColor), image->getData());
+	cairo_surface_destroy(s);
+	return TRUE;
+}
+
+
+FXVectorImage::~FXVectorImage()
+{
+	clear();
+}
+
+
+/*******************************************************************************/
+
+// Sizes rasterized for icons
+static const FXint iconLadder[] = { 16, 24, 32, 48, 64, 96, 128, 192, 256 };
+
+
+// Construct empty icon
+FXVectorIcon::FXVectorIcon(FXint sz):
+	size(sz)
+{
+}
+
+
+// Construct icon from SVG data
+FXVectorIcon::FXVectorIcon(const void* data,FXuval len,FXint sz):
+	FXVectorImage(data, len),
+	size(sz)
+{
+}
+
+
+// Scale natural size so that the larger dimension is sz
+void FXVectorIcon::getIconSize(FXint sz,FXint& w,FXint& h) const
+{
+	FXdouble m = FXMAX(width, height);
+	if (m <= 0.) {
+		w = h = sz;
+		return;
+	}
+	w = FXMAX(1, (FXint)(width*sz/m + 0.5));
+	h = FXMAX(1, (FXint)(height*sz/m + 0.5));
+}
+
+
+// Nearest rung not smaller than sz
+FXint FXVectorIcon::getLadderSize(FXint sz)
+{
+	for (FXuint i = 0; i < ARRAYNUMBER(iconLadder); ++i)
+		if (iconLadder[i] >= sz)
+			return iconLadder[i];
+	return sz;
+}
+
+}
@@ -0,0 +1,162 @@
+/********************************************************************************
+*                                                                               *
+*                        V e c t o r   I m a g e                                *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2013 by Stephen J. Hardy.   All Rights Reserved.                *
+*********************************************************************************
+* This library is free software; you can redistribute it and/or                 *
+* modify it under the terms of the GNU Lesser General Public                    *
+* License as published by the Free Software Foundation; either                  *
+* version 2.1 of the License, or (at your option) any later version.            *
+*                                                                               *
+* This library is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU             *
+* Lesser General Public License for more details.                               *
+*                                                                               *
+* You should have received a copy of the GNU Lesser General Public              *
+* License along with this library; if not, write to the Free Software           *
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.    *
+*********************************************************************************
+* $Id: $                        *
+********************************************************************************/
+#ifndef FXVECTORIMAGE_H
+#define FXVECTORIMAGE_H
+
+#ifndef FXDCCAIRO_H
+#include "FXDCCairo.h"
+#endif
+
+namespace FX
+{
+
+
+/**
+* A scalable image, rasterized on demand at whatever size it is drawn.
+*
+* The image is loaded once (from SVG, or from a display list drawn with the
+* FXDC API) into a Cairo recording surface, which holds the drawing
+* operations rather than pixels.  FXDCCairo::drawVectorImage() draws it at any
+* size; rasters are made for the size in device pixels, so a HiDPI or zoomed
+* view gets a sharp image, and are kept in FXDCCairo's image cache, so the
+* same size is not rasterized again on every expose.
+*
+*   FXVectorImage car;
+*   car.loadSVGFile("car.svg");
+*   ...
+*   FXDCCairo dc(this, event);
+*   dc.drawVectorImage(&car, x, y, 250, 170);
+*
+* SVG needs librsvg, which configure uses if it is installed; see canLoadSVG().
+* When the image is changed or destroyed, its rasters are dropped from the
+* cache.
+*/
+class FXAPI FXVectorImage
+{
+protected:
+	void * recording;		// cairo_surface_t *, NULL if empty
+	FXdouble width;			// Natural size
+	FXdouble height;
+
+	void setRecording(void * rec, FXdouble w, FXdouble h);
+
+private:
+	FXVectorImage(const FXVectorImage&);
+	FXVectorImage &operator=(const FXVectorImage&);
+public:
+
+	/// Construct empty image
+	FXVectorImage();
+
+	/// Construct from SVG data in memory (empty if it can't be loaded)
+	FXVectorImage(const void* data,FXuval size);
+
+	/// Return TRUE if this library can load SVG
+	static FXbool canLoadSVG();
+
+	/// Load SVG data from memory.  Returns FALSE, leaving the image empty,
+	/// if the data is not valid SVG or SVG is not supported.
+	FXbool loadSVG(const void* data,FXuval size);
+
+	/// Load SVG file
+	FXbool loadSVGFile(const FXString& filename);
+
+	/// Use a recorded display list as the image, with the given natural size.
+	/// The recording is shared with the list, so the list may be invalidated.
+	FXbool setDisplayList(const FXCairoDisplayList& list,FXdouble w,FXdouble h);
+
+	/// Make empty
+	void clear();
+
+	/// Return TRUE if there is something to draw
+	FXbool isValid() const { return recording != NULL; }
+
+	/// Natural size, in pixels at scale 1
+	FXdouble getWidth() const { return width; }
+	FXdouble getHeight() const { return height; }
+
+	/// The recording surface (cairo_surface_t *), or NULL
+	void * getRecording() const { return recording; }
+
+	/// Return a new ARGB32 image surface (cairo_surface_t *) of w*h pixels,
+	/// with the image scaled to fill it, or NULL if empty.  Not cached; see
+	/// FXDCCairo::getVectorRaster() for the cached version.
+	void * rasterize(FXint w,FXint h) const;
+
+	/// Render into the client pixels of image, scaled to its size.  The
+	/// image must have client data (IMAGE_KEEP, or made with data); call
+	/// image->render() afterwards to send it to the server.
+	FXbool render(FXImage* image) const;
+
+	/// Destructor
+	~FXVectorImage();
+};
+
+
+/**
+* A vector image used as an icon, drawn at a few fixed sizes many times over.
+*
+* Rasters are only made for the sizes of a ladder (16, 24, 32, 48, 64, 96,
+* 128, 192 and 256 pixels, for the larger dimension), as they are first
+* needed, and kept in the image cache.  An icon drawn at another size (in
+* device pixels) is scaled down from the nearest larger rung with a bilinear
+* filter, so repeated drawing only ever costs a blit.  Above the top rung,
+* rasters are made at the exact size.
+*
+*   FXVectorIcon open(24);
+*   open.loadSVGFile("document-open.svg");
+*   ...
+*   dc.drawIcon(&open, x, y);
+*/
+class FXAPI FXVectorIcon : public FXVectorImage
+{
+protected:
+	FXint size;				// Default size
+
+private:
+	FXVectorIcon(const FXVectorIcon&);
+	FXVectorIcon &operator=(const FXVectorIcon&);
+public:
+
+	/// Construct empty icon, drawn at size pixels by default
+	FXVectorIcon(FXint sz=16);
+
+	/// Construct from SVG data in memory
+	FXVectorIcon(const void* data,FXuval len,FXint sz=16);
+
+	/// Change the default size (the larger dimension, in pixels)
+	void setSize(FXint sz) { size = sz; }
+	FXint getSize() const { return size; }
+
+	/// Width and height of the icon when drawn at sz pixels
+	void getIconSize(FXint sz,FXint& w,FXint& h) const;
+
+	/// Size of the raster used to draw at sz device pixels: the smallest rung
+	/// of the ladder not less than sz, or sz itself if above the ladder
+	static FXint getLadderSize(FXint sz);
+};
+
+}
+
+#endif
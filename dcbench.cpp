@@ -0,0 +1,763 @@
+/********************************************************************************
+*                                                                               *
+*              Benchmarks for batched drawing operations in FXDCCairo           *
+*                                                                               *
+********************************************************************************/
+#include "xincs_cairo.h"
+#include "fx.h"
+#include "FXDCCairo.h"
+#include "FXDCCairoImage.h"
+#include "FXDCCairoParallel.h"
+#include "FXCairoDisplayList.h"
+#include "FXVectorImage.h"
+
+/*
+	Each benchmark draws into an off-screen FXImage, comparing the batched
+	FXDC calls with the equivalent loop of single calls.  Needs a display
+	(Xvfb will do).  Output is one line per measurement:
+
+		<benchmark> <variant> <items> <items/s> <ns/item>
+
+	Usage: dcbench [benchmark...]
+	With no arguments, runs all benchmarks.
+*/
+
+static FXApp * app;
+static FXImage * target;
+
+#define TARGET_W 1000
+#define TARGET_H 1000
+
+
+// Run f on a fresh DC reps times, and report the rate of items drawn
+static void bench(const char * name, const char * variant, FXuint items, FXuint reps,
+		void (*f)(FXDCCairo & dc))
+{
+	{
+		// Warm up caches
+		FXDCCairo dc(target);
+		f(dc);
+	}
+	app->flush(TRUE);
+	FXTime t0 = FXThread::time();
+	for (FXuint r = 0; r < reps; ++r) {
+		FXDCCairo dc(target);
+		f(dc);
+	}
+	app->flush(TRUE);
+	FXTime t1 = FXThread::time();
+	double ns = (double)(t1 - t0)/((double)reps*items);
+	printf("%s %s %u %.0f %.1f\n", name, variant, items, 1.e9/ns, ns);
+	fflush(stdout);
+}
+
+
+/*******************************************************************************/
+
+// fillRectangles: 200x200 heat map of 5x5 cells in 16 colour bands
+
+#define HEAT_N 200
+#define HEAT_CELL 5
+#define HEAT_COLORS 16
+
+static FXRectangle heatCells[HEAT_COLORS][HEAT_N*HEAT_N];
+static FXuint heatCount[HEAT_COLORS];
+static FXRectangle overlapRects[HEAT_N*HEAT_N];
+static FXuchar heatAlpha;
+
+static FXColor heatColor(FXuint c)
+{
+	return FXRGBA(c*16, 64, 255-c*16, heatAlpha);
+}
+
+static void fillHeatSingle(FXDCCairo & dc)
+{
+	for (FXuint c = 0; c < HEAT_COLORS; ++c) {
+		dc.setForeground(heatColor(c));
+		for (FXuint i = 0; i < heatCount[c]; ++i)
+			dc.fillRectangle(heatCells[c][i].x, heatCells[c][i].y, heatCells[c][i].w, heatCells[c][i].h);
+	}
+}
+
+static void fillHeatBatch(FXDCCairo & dc)
+{
+	for (FXuint c = 0; c < HEAT_COLORS; ++c) {
+		dc.setForeground(heatColor(c));
+		dc.fillRectangles(heatCells[c], heatCount[c]);
+	}
+}
+
+static void fillOverlapSingle(FXDCCairo & dc)
+{
+	dc.setForeground(FXRGBA(255,0,0,128));
+	for (FXuint i = 0; i < HEAT_N*HEAT_N/16; ++i)
+		dc.fillRectangle(overlapRects[i].x, overlapRects[i].y, overlapRects[i].w, overlapRects[i].h);
+}
+
+static void fillOverlapBatch(FXDCCairo & dc)
+{
+	dc.setForeground(FXRGBA(255,0,0,128));
+	dc.fillRectangles(overlapRects, HEAT_N*HEAT_N/16);
+}
+
+static void benchFillRects()
+{
+	for (FXuint i = 0; i < HEAT_N*HEAT_N; ++i) {
+		FXuint c = (i*7 + i/HEAT_N*3) % HEAT_COLORS;
+		FXRectangle & r = heatCells[c][heatCount[c]++];
+		r.x = (i % HEAT_N)*HEAT_CELL;
+		r.y = (i / HEAT_N)*HEAT_CELL;
+		r.w = HEAT_CELL;
+		r.h = HEAT_CELL;
+		// Overlapping 8x8 rectangles on a 5 pixel pitch
+		overlapRects[i].x = r.x;
+		overlapRects[i].y = r.y;
+		overlapRects[i].w = 8;
+		overlapRects[i].h = 8;
+	}
+	heatAlpha = 255;
+	bench("fillrects", "opaque-single", HEAT_N*HEAT_N, 5, fillHeatSingle);
+	bench("fillrects", "opaque-batch", HEAT_N*HEAT_N, 5, fillHeatBatch);
+	heatAlpha = 160;
+	bench("fillrects", "translucent-single", HEAT_N*HEAT_N, 5, fillHeatSingle);
+	bench("fillrects", "translucent-batch", HEAT_N*HEAT_N, 5, fillHeatBatch);
+	bench("fillrects", "overlap-single", HEAT_N*HEAT_N/16, 5, fillOverlapSingle);
+	bench("fillrects", "overlap-batch", HEAT_N*HEAT_N/16, 5, fillOverlapBatch);
+}
+
+
+/*******************************************************************************/
+
+// drawPoints: scatter plot of 100000 points
+
+#define SCATTER_N 100000
+
+static FXPoint scatter[SCATTER_N];
+static FXColor scatterColor;
+
+static void drawScatterSingle(FXDCCairo & dc)
+{
+	dc.setForeground(scatterColor);
+	for (FXuint i = 0; i < SCATTER_N; ++i)
+		dc.drawPoint(scatter[i].x, scatter[i].y);
+}
+
+static void drawScatterBatch(FXDCCairo & dc)
+{
+	dc.setForeground(scatterColor);
+	dc.drawPoints(scatter, SCATTER_N);
+}
+
+static void benchPoints()
+{
+	FXuint seed = 12345;
+	for (FXuint i = 0; i < SCATTER_N; ++i) {
+		seed = seed*1103515245 + 12345;
+		scatter[i].x = (seed>>8) % TARGET_W;
+		seed = seed*1103515245 + 12345;
+		scatter[i].y = (seed>>8) % TARGET_H;
+	}
+	scatterColor = FXRGB(0,0,128);
+	bench("points", "opaque-single", SCATTER_N, 2, drawScatterSingle);
+	bench("points", "opaque-batch", SCATTER_N, 2, drawScatterBatch);
+	scatterColor = FXRGBA(0,0,128,96);
+	bench("points", "translucent-single", SCATTER_N, 2, drawScatterSingle);
+	bench("points", "translucent-batch", SCATTER_N, 2, drawScatterBatch);
+}
+
+
+/*******************************************************************************/
+
+// FXDCCairoImage: small line charts rendered into memory, one DC per image
+
+#define THUMB_W 160
+#define THUMB_H 120
+#define THUMB_N 500
+
+static void drawThumb(FXDCCairoImage & dc, FXuint n)
+{
+	FXPoint pts[32];
+	dc.setForeground(FXRGB(255,255,255));
+	dc.fillRectangle(0, 0, THUMB_W, THUMB_H);
+	dc.setForeground(FXRGB(200,200,200));
+	for (FXint y = 20; y < THUMB_H; y += 20)
+		dc.drawLine(0, y, THUMB_W, y);
+	for (FXuint i = 0; i < ARRAYNUMBER(pts); ++i) {
+		pts[i].x = (FXshort)(i*THUMB_W/(ARRAYNUMBER(pts)-1));
+		pts[i].y = (FXshort)(THUMB_H/2 + ((i*7 + n*13) % 41) - 20);
+	}
+	dc.setForeground(FXRGB(0,0,192));
+	dc.setLineWidth(2);
+	dc.drawLines(pts, ARRAYNUMBER(pts));
+}
+
+static void benchThumbs()
+{
+	FXint stride = FXDCCairoImage::getStride(THUMB_W);
+	FXuchar * buf;
+	FXMALLOC(&buf, FXuchar, stride*THUMB_H);
+	{
+		FXDCCairoImage dc(app, buf, THUMB_W, THUMB_H, stride);
+		drawThumb(dc, 0);
+	}
+	FXTime t0 = FXThread::time();
+	for (FXuint n = 0; n < THUMB_N; ++n) {
+		FXDCCairoImage dc(app, buf, THUMB_W, THUMB_H, stride);
+		drawThumb(dc, n);
+	}
+	FXTime t1 = FXThread::time();
+	double ns = (double)(t1 - t0)/THUMB_N;
+	printf("%s %s %u %.0f %.1f\n", "thumbs", "image-dc", THUMB_N, 1.e9/ns, ns);
+	fflush(stdout);
+	FXFREE(&buf);
+}
+
+
+/*******************************************************************************/
+
+// FXDCCairoParallel: a busy 4K frame replayed on 1, 2, 4 and 8 threads
+
+#define FRAME_W 3840
+#define FRAME_H 2160
+
+static FXImage * frameTarget;
+
+static void drawFrame(FXDCCairo & dc)
+{
+	dc.setForeground(FXRGB(255,255,255));
+	dc.fillRectangle(0, 0, FRAME_W, FRAME_H);
+	FXuint seed = 12345;
+	for (FXuint i = 0; i < 4000; ++i) {
+		seed = seed*1103515245 + 12345;
+		FXint x = (seed>>8) % FRAME_W;
+		seed = seed*1103515245 + 12345;
+		FXint y = (seed>>8) % FRAME_H;
+		dc.setForeground(FXRGBA(seed>>24, (seed>>16)&255, 128, 160));
+		dc.fillEllipse(x-40, y-30, 80, 60);
+		dc.setForeground(FXRGB(0,0,0));
+		dc.setLineWidth(3);
+		dc.drawLine(x, y, x+120, y+(FXint)((seed>>20)&63)-32);
+	}
+}
+
+static void benchParallel()
+{
+	frameTarget = new FXImage(app, NULL, 0, FRAME_W, FRAME_H);
+	frameTarget->create();
+	const FXuint reps = 3;
+	static const FXuint threads[] = { 1, 2, 4, 8 };
+	for (FXint t = -1; t < (FXint)ARRAYNUMBER(threads); ++t) {
+		FXchar variant[32];
+		if (t < 0)
+			strcpy(variant, "direct");
+		else {
+			sprintf(variant, "threads-%u", threads[t]);
+			FXDCCairoParallel::setThreads(threads[t]);
+		}
+		FXTime t0 = 0;
+		for (FXuint r = 0; r <= reps; ++r) {
+			if (r == 1) {
+				// First one was warm-up
+				app->flush(TRUE);
+				t0 = FXThread::time();
+			}
+			if (t < 0) {
+				FXDCCairo dc(frameTarget);
+				drawFrame(dc);
+			}
+			else {
+				FXDCCairoParallel dc(frameTarget);
+				drawFrame(dc);
+			}
+		}
+		app->flush(TRUE);
+		FXTime t1 = FXThread::time();
+		double ns = (double)(t1 - t0)/reps;
+		printf("%s %s %u %.2f %.1f\n", "parallel", variant, 1, 1.e9/ns, ns);
+		fflush(stdout);
+	}
+	FXDCCairoParallel::setThreads(0);
+	FXDCCairo::releaseSurface(frameTarget);
+	delete frameTarget;
+}
+
+
+/*******************************************************************************/
+
+// FXCairoDisplayList: a table-like widget redrawn directly, and from a list
+
+static FXFont * tableFont;
+static FXCairoDisplayList tableList;
+
+static void drawTable(FXDCCairo & dc)
+{
+	FXchar cell[32];
+	dc.setFont(tableFont);
+	for (FXint r = 0; r < 40; ++r) {
+		dc.setForeground(r & 1 ? FXRGB(240,240,255) : FXRGB(255,255,255));
+		dc.fillRectangle(0, r*20, 800, 20);
+		dc.setForeground(FXRGB(0,0,0));
+		for (FXint c = 0; c < 8; ++c) {
+			sprintf(cell, "%d.%02d", r*8 + c, (r*37 + c*11) % 100);
+			dc.drawText(c*100 + 4, r*20 + 15, cell, strlen(cell));
+		}
+	}
+	dc.setForeground(FXRGB(128,128,128));
+	for (FXint c = 1; c < 8; ++c)
+		dc.drawLine(c*100, 0, c*100, 800);
+}
+
+static void drawTableList(FXDCCairo & dc)
+{
+	dc.drawDisplayList(tableList);
+}
+
+static void benchDisplayList()
+{
+	tableFont = new FXFont(app, "helvetica", 9);
+	{
+		FXDCCairoRecorder rec(target, tableList);
+		drawTable(rec);
+	}
+	bench("displaylist", "direct", 1, 50, drawTable);
+	bench("displaylist", "replay", 1, 50, drawTableList);
+	printf("displaylist size %u %lu\n", tableList.getOperations(), (unsigned long)tableList.getMemorySize());
+	tableList.invalidate();
+	delete tableFont;
+}
+
+
+/*******************************************************************************/
+
+// setClipMask: small rectangles with no mask, a disc mask (used as a clip) and
+// a checkerboard mask (too many rectangles; painted through a group)
+
+#define MASK_SIZE 400
+#define MASK_PRIMS 2000
+
+static FXBitmap * maskBitmap;
+static FXuchar maskBits[((MASK_SIZE+7)/8)*MASK_SIZE];
+
+static void fillMaskPrims(FXDCCairo & dc)
+{
+	if (maskBitmap)
+		dc.setClipMask(maskBitmap, 100, 100);
+	dc.setForeground(FXRGB(0,128,0));
+	for (FXuint i = 0; i < MASK_PRIMS; ++i)
+		dc.fillRectangle(100 + (i*37) % MASK_SIZE, 100 + (i*91) % MASK_SIZE, 12, 12);
+	if (maskBitmap)
+		dc.clearClipMask();
+}
+
+static void makeMask(FXbool disc)
+{
+	FXint stride = (MASK_SIZE+7)/8;
+	memset(maskBits, 0, sizeof(maskBits));
+	for (FXint y = 0; y < MASK_SIZE; ++y) {
+		for (FXint x = 0; x < MASK_SIZE; ++x) {
+			FXint dx = x - MASK_SIZE/2;
+			FXint dy = y - MASK_SIZE/2;
+			FXbool on = disc ? dx*dx + dy*dy < MASK_SIZE*MASK_SIZE/4 : ((x ^ y) & 1);
+			if (on)
+				maskBits[y*stride + (x>>3)] |= 1<<(x&7);
+		}
+	}
+	maskBitmap = new FXBitmap(app, maskBits, BITMAP_KEEP, MASK_SIZE, MASK_SIZE);
+	maskBitmap->create();
+}
+
+static void benchMask()
+{
+	maskBitmap = NULL;
+	bench("mask", "none", MASK_PRIMS, 10, fillMaskPrims);
+	makeMask(TRUE);
+	bench("mask", "disc-clip", MASK_PRIMS, 10, fillMaskPrims);
+	FXDCCairo::invalidateImage(maskBitmap);
+	delete maskBitmap;
+	makeMask(FALSE);
+	bench("mask", "checker-group", MASK_PRIMS, 10, fillMaskPrims);
+	FXDCCairo::invalidateImage(maskBitmap);
+	delete maskBitmap;
+	maskBitmap = NULL;
+}
+
+
+// Stipples: rectangles filled with the grey stipple, transparent and opaque,
+// then cycling through all the built-in patterns
+
+#define STIPPLE_PRIMS 2000
+
+static FXFillStyle stippleStyle;
+static FXbool stippleCycle;
+
+static void fillStipplePrims(FXDCCairo & dc)
+{
+	dc.setForeground(FXRGB(0,0,160));
+	dc.setBackground(FXRGB(255,255,200));
+	dc.setFillStyle(stippleStyle);
+	dc.setStipple(STIPPLE_GRAY);
+	for (FXuint i = 0; i < STIPPLE_PRIMS; ++i) {
+		if (stippleCycle)
+			dc.setStipple((FXStipplePattern)(i % (STIPPLE_CROSSDIAG+1)));
+		dc.fillRectangle((i*37) % 900, (i*91) % 900, 40, 40);
+	}
+}
+
+static void benchStipple()
+{
+	stippleCycle = FALSE;
+	stippleStyle = FILL_STIPPLED;
+	bench("stipple", "stippled", STIPPLE_PRIMS, 10, fillStipplePrims);
+	stippleStyle = FILL_OPAQUESTIPPLED;
+	bench("stipple", "opaque", STIPPLE_PRIMS, 10, fillStipplePrims);
+	stippleCycle = TRUE;
+	bench("stipple", "patterns", STIPPLE_PRIMS, 10, fillStipplePrims);
+}
+
+
+// drawArea: scroll the whole target up by a few rows, as a scrolling canvas
+// does.  The stretch overload at 1:1 always takes the general path.
+
+#define SCROLL_STEPS 20
+#define SCROLL_ROWS 8
+
+static void scrollCopy(FXDCCairo & dc)
+{
+	for (FXuint i = 0; i < SCROLL_STEPS; ++i)
+		dc.drawArea(target, 0, SCROLL_ROWS, TARGET_W, TARGET_H-SCROLL_ROWS, 0, 0);
+}
+
+static void scrollPattern(FXDCCairo & dc)
+{
+	for (FXuint i = 0; i < SCROLL_STEPS; ++i)
+		dc.drawArea(target, 0, SCROLL_ROWS, TARGET_W, TARGET_H-SCROLL_ROWS, 0, 0,
+			TARGET_W, TARGET_H-SCROLL_ROWS);
+}
+
+static void benchScroll()
+{
+	bench("scroll", "xcopyarea", SCROLL_STEPS, 10, scrollCopy);
+	bench("scroll", "pattern", SCROLL_STEPS, 10, scrollPattern);
+}
+
+
+// drawIcon: a grid of 24x24 colour-keyed icons, as in a large toolbar or list,
+// drawn normal, shaded (selected) and sunken (disabled); and a vector icon at
+// a size on its ladder (24) and between sizes (20)
+
+#define ICON_SIZE 24
+#define ICON_N 1000
+
+static FXIcon * benchIcon;
+static FXColor iconPixels[ICON_SIZE*ICON_SIZE];
+static void (FXDCCairo::*iconDraw)(const FXIcon*,FXint,FXint);
+static FXCairoDisplayList vectorIconList;
+static FXVectorIcon vectorIcon;
+static FXint vectorIconSize;
+
+static void drawIcons(FXDCCairo & dc)
+{
+	for (FXuint i = 0; i < ICON_N; ++i)
+		(dc.*iconDraw)(benchIcon, (i % 40)*ICON_SIZE, (i / 40)*ICON_SIZE);
+}
+
+static void drawVectorIcons(FXDCCairo & dc)
+{
+	for (FXuint i = 0; i < ICON_N; ++i)
+		dc.drawIcon(&vectorIcon, (i % 40)*ICON_SIZE, (i / 40)*ICON_SIZE, vectorIconSize);
+}
+
+static void benchIcons()
+{
+	FXColor transp = FXRGB(255,0,255);
+	for (FXint y = 0; y < ICON_SIZE; ++y) {
+		for (FXint x = 0; x < ICON_SIZE; ++x) {
+			FXint dx = 2*x - ICON_SIZE + 1;
+			FXint dy = 2*y - ICON_SIZE + 1;
+			iconPixels[y*ICON_SIZE + x] = dx*dx + dy*dy < ICON_SIZE*ICON_SIZE ?
+				FXRGB(x*10, 255 - y*10, 128) : transp;
+		}
+	}
+	benchIcon = new FXIcon(app, iconPixels, transp, IMAGE_KEEP|IMAGE_ALPHACOLOR, ICON_SIZE, ICON_SIZE);
+	benchIcon->create();
+	iconDraw = &FXDCCairo::drawIcon;
+	bench("icons", "normal", ICON_N, 10, drawIcons);
+	iconDraw = &FXDCCairo::drawIconShaded;
+	bench("icons", "shaded", ICON_N, 10, drawIcons);
+	iconDraw = &FXDCCairo::drawIconSunken;
+	bench("icons", "sunken", ICON_N, 10, drawIcons);
+	FXDCCairo::invalidateImage(benchIcon);
+	delete benchIcon;
+	{
+		FXDCCairoRecorder rec(target, vectorIconList);
+		rec.setForeground(FXRGB(40,160,80));
+		rec.fillEllipse(0, 0, ICON_SIZE, ICON_SIZE);
+		rec.setForeground(FXRGB(255,255,255));
+		rec.fillRectangle(ICON_SIZE/4, ICON_SIZE*5/12, ICON_SIZE/2, ICON_SIZE/6);
+	}
+	vectorIcon.setDisplayList(vectorIconList, ICON_SIZE, ICON_SIZE);
+	vectorIconSize = 24;
+	bench("icons", "vector", ICON_N, 10, drawVectorIcons);
+	vectorIconSize = 20;
+	bench("icons", "vector-scaled", ICON_N, 10, drawVectorIcons);
+	vectorIcon.clear();
+	vectorIconList.invalidate();
+}
+
+
+/*******************************************************************************/
+
+// drawArcs/fillArcs: a grid of 400 small gauges (arcs that don't overlap), and
+// 400 pie slices around one centre (which do)
+
+#define ARC_N 400
+
+static FXArc gaugeArcs[ARC_N];
+static FXArc pieArcs[ARC_N];
+static FXArc * arcSet;
+static FXuchar arcAlpha;
+
+static void drawArcsSingle(FXDCCairo & dc)
+{
+	dc.setForeground(FXRGBA(20,60,200,arcAlpha));
+	dc.setLineWidth(3);
+	for (FXuint i = 0; i < ARC_N; ++i)
+		dc.drawArc(arcSet[i].x, arcSet[i].y, arcSet[i].w, arcSet[i].h, arcSet[i].a, arcSet[i].b);
+}
+
+static void drawArcsBatch(FXDCCairo & dc)
+{
+	dc.setForeground(FXRGBA(20,60,200,arcAlpha));
+	dc.setLineWidth(3);
+	dc.drawArcs(arcSet, ARC_N);
+}
+
+static void fillArcsSingle(FXDCCairo & dc)
+{
+	dc.setForeground(FXRGBA(200,60,20,arcAlpha));
+	for (FXuint i = 0; i < ARC_N; ++i)
+		dc.fillArc(arcSet[i].x, arcSet[i].y, arcSet[i].w, arcSet[i].h, arcSet[i].a, arcSet[i].b);
+}
+
+static void fillArcsBatch(FXDCCairo & dc)
+{
+	dc.setForeground(FXRGBA(200,60,20,arcAlpha));
+	dc.fillArcs(arcSet, ARC_N);
+}
+
+static void benchArcs()
+{
+	for (FXuint i = 0; i < ARC_N; ++i) {
+		gaugeArcs[i].x = (i % 20)*50 + 5;
+		gaugeArcs[i].y = (i / 20)*50 + 5;
+		gaugeArcs[i].w = 40;
+		gaugeArcs[i].h = 40;
+		gaugeArcs[i].a = -45*64;
+		gaugeArcs[i].b = (FXshort)(-(FXint)(i*7 % 270)*64);
+		pieArcs[i].x = 100;
+		pieArcs[i].y = 100;
+		pieArcs[i].w = 800;
+		pieArcs[i].h = 800;
+		pieArcs[i].a = (FXshort)(i*360*64/ARC_N);
+		pieArcs[i].b = (FXshort)(360*64/ARC_N + 64);
+	}
+	arcSet = gaugeArcs;
+	arcAlpha = 255;
+	bench("arcs", "draw-single", ARC_N, 20, drawArcsSingle);
+	bench("arcs", "draw-batch", ARC_N, 20, drawArcsBatch);
+	bench("arcs", "fill-single", ARC_N, 20, fillArcsSingle);
+	bench("arcs", "fill-batch", ARC_N, 20, fillArcsBatch);
+	arcAlpha = 128;
+	bench("arcs", "fill-alpha-single", ARC_N, 20, fillArcsSingle);
+	bench("arcs", "fill-alpha-batch", ARC_N, 20, fillArcsBatch);
+	arcSet = pieArcs;
+	arcAlpha = 255;
+	bench("arcs", "pie-single", ARC_N, 20, fillArcsSingle);
+	bench("arcs", "pie-batch", ARC_N, 20, fillArcsBatch);
+	arcAlpha = 128;
+	bench("arcs", "pie-alpha-batch", ARC_N, 20, fillArcsBatch);
+}
+
+
+/*******************************************************************************/
+
+// drawTexts: a table of 50 rows by 8 columns of numbers, as in a log viewer
+
+#define TEXT_ROWS 50
+#define TEXT_COLS 8
+#define TEXT_N (TEXT_ROWS*TEXT_COLS)
+
+static FXFont * textFont;
+static FXchar textCells[TEXT_N][16];
+static FXCairoText texts[TEXT_N];
+
+static void drawTextsSingle(FXDCCairo & dc)
+{
+	dc.setFont(textFont);
+	dc.setForeground(FXRGB(0,0,0));
+	for (FXuint i = 0; i < TEXT_N; ++i)
+		dc.drawText(texts[i].x, texts[i].y, texts[i].text, texts[i].length);
+}
+
+static void drawTextsBatch(FXDCCairo & dc)
+{
+	dc.setFont(textFont);
+	dc.setForeground(FXRGB(0,0,0));
+	dc.drawTexts(texts, TEXT_N);
+}
+
+static void benchTexts()
+{
+	textFont = new FXFont(app, "helvetica", 9);
+	for (FXuint i = 0; i < TEXT_N; ++i) {
+		FXuint n = sprintf(textCells[i], "%.3f", (i*7919 % 100000)/7.);
+		texts[i].x = (i % TEXT_COLS)*120 + 10;
+		texts[i].y = (i / TEXT_COLS)*20 + 20;
+		texts[i].text = textCells[i];
+		texts[i].length = n;
+	}
+	bench("texts", "single", TEXT_N, 20, drawTextsSingle);
+	bench("texts", "batch", TEXT_N, 20, drawTextsBatch);
+	FXDCCairo::invalidateFont(textFont);
+	delete textFont;
+}
+
+
+/*******************************************************************************/
+
+// FXVectorImage: a 64x64 drawing shown at 200x200, with the raster from the
+// image cache, and rasterized again every time
+
+#define VECTOR_N 20
+
+static FXCairoDisplayList vectorList;
+static FXVectorImage vectorImage;
+
+static void drawVectorArt(FXDCCairo & dc)
+{
+	dc.setForeground(FXRGB(40,80,160));
+	dc.fillEllipse(2, 2, 60, 60);
+	dc.setForeground(FXRGB(250,200,40));
+	for (FXint a = 0; a < 360; a += 30)
+		dc.fillArc(8, 8, 48, 48, a*64, 15*64);
+	dc.setForeground(FXRGB(0,0,0));
+	dc.setLineWidth(2);
+	dc.drawEllipse(2, 2, 60, 60);
+}
+
+static void drawVectorCached(FXDCCairo & dc)
+{
+	for (FXuint i = 0; i < VECTOR_N; ++i)
+		dc.drawVectorImage(&vectorImage, (i % 5)*200, (i / 5)*200, 200, 200);
+}
+
+static void drawVectorUncached(FXDCCairo & dc)
+{
+	for (FXuint i = 0; i < VECTOR_N; ++i) {
+		FXDCCairo::invalidateImage(&vectorImage);
+		dc.drawVectorImage(&vectorImage, (i % 5)*200, (i / 5)*200, 200, 200);
+	}
+}
+
+static void benchVector()
+{
+	{
+		FXDCCairoRecorder rec(target, vectorList);
+		drawVectorArt(rec);
+	}
+	vectorImage.setDisplayList(vectorList, 64, 64);
+	bench("vector", "cached", VECTOR_N, 20, drawVectorCached);
+	bench("vector", "rasterize", VECTOR_N, 20, drawVectorUncached);
+	vectorImage.clear();
+	vectorList.invalidate();
+}
+
+
+/*******************************************************************************/
+
+// setImagePremultiplied: a 400x400 image updated before every draw, sent to
+// the server with render(), or drawn in place from its client buffer
+
+#define PREMUL_SIZE 400
+
+static FXImage * premulImage;
+
+static void drawPremulRender(FXDCCairo & dc)
+{
+	premulImage->render();
+	dc.drawImage(premulImage, 0, 0);
+}
+
+static void drawPremulWrap(FXDCCairo & dc)
+{
+	FXDCCairo::invalidateImage(premulImage);
+	dc.drawImage(premulImage, 0, 0);
+}
+
+static void benchPremultiplied()
+{
+	premulImage = new FXImage(app, NULL, IMAGE_KEEP|IMAGE_OWNED, PREMUL_SIZE, PREMUL_SIZE);
+	premulImage->create();
+	{
+		FXDCCairoImage dc(app, (FXuchar *)premulImage->getData(), PREMUL_SIZE, PREMUL_SIZE,
+			FXDCCairoImage::getStride(PREMUL_SIZE));
+		dc.setForeground(FXRGB(255,255,255));
+		dc.fillRectangle(0, 0, PREMUL_SIZE, PREMUL_SIZE);
+		dc.setForeground(FXRGBA(200,0,0,128));
+		dc.fillEllipse(20, 20, PREMUL_SIZE-40, PREMUL_SIZE-40);
+	}
+	bench("premultiplied", "render", 1, 50, drawPremulRender);
+	FXDCCairo::setImagePremultiplied(premulImage);
+	bench("premultiplied", "wrap", 1, 50, drawPremulWrap);
+	FXDCCairo::setImagePremultiplied(premulImage, FALSE);
+	delete premulImage;
+}
+
+
+/*******************************************************************************/
+
+struct Benchmark {
+	const char * name;
+	void (*run)();
+};
+
+static const Benchmark benchmarks[] = {
+	{ "fillrects", benchFillRects },
+	{ "points", benchPoints },
+	{ "thumbs", benchThumbs },
+	{ "parallel", benchParallel },
+	{ "displaylist", benchDisplayList },
+	{ "mask", benchMask },
+	{ "stipple", benchStipple },
+	{ "scroll", benchScroll },
+	{ "icons", benchIcons },
+	{ "arcs", benchArcs },
+	{ "texts", benchTexts },
+	{ "vector", benchVector },
+	{ "premultiplied", benchPremultiplied },
+};
+
+
+// Here we begin
+int main(int argc,char *argv[])
+{
+	FXApp application("DCBench","FoxTest");
+	application.init(argc,argv);
+	application.create();
+	app = &application;
+
+	target = new FXImage(app, NULL, 0, TARGET_W, TARGET_H);
+	target->create();
+
+	for (FXuint i = 0; i < ARRAYNUMBER(benchmarks); ++i) {
+		FXbool run = argc < 2;
+		for (int a = 1; a < argc; ++a)
+			if (!strcmp(argv[a], benchmarks[i].name))
+				run = TRUE;
+		if (run)
+			benchmarks[i].run();
+	}
+
+	delete target;
+	return 0;
+}
@@ -0,0 +1,594 @@
+/********************************************************************************
+*                                                                               *
+*         Test scenes shared by dctest, dctest2 and scenebench                  *
+*                                                                               *
+*********************************************************************************
+* drawPageScene() is from the FOX test dctest,                                  *
+* Copyright (C) 1999,2006 by Jeroen van der Zijp.   All Rights Reserved.        *
+********************************************************************************/
+#include "xincs_cairo.h"
+#include "fx.h"
+#include "dcscenes.h"
+
+#include "FXPNGImage.h"
+#include "FXPNGIcon.h"
+#include "images.cpp"
+
+
+// This is the WYSIWYG routine, it takes a DC and renders
+// into it; it does not know if the DC is a printer or screen.
+void drawPageScene(FXDC& dc,FXint w,FXint h,const DCPage& p){
+
+  dc.setForeground(p.erasecolor);
+  dc.fillRectangle(0,0,w,h);
+
+  dc.setForeground(p.forecolor);
+  dc.setBackground(p.backcolor);
+
+  dc.setLineStyle(p.lineStyle);
+  dc.setLineCap(p.capStyle);
+  dc.setLineJoin(p.joinStyle);
+  dc.setFunction(p.function);
+
+  dc.setStipple(p.stipple);
+  dc.setFillStyle(p.fillStyle);
+  dc.setLineWidth(p.lineWidth);
+  dc.setTile(p.textureImage);
+
+  // Here's a single line
+  dc.drawLine(20,200,w-20,200);
+
+  // Here are some connected lines (to show join styles)
+  FXPoint points[6];
+  points[0].x=10;              points[0].y=3*h/4;
+  points[1].x=points[0].x+w/6; points[1].y=h/2;
+  points[2].x=points[1].x+w/6; points[2].y=points[0].y;
+  points[3].x=points[2].x+w/6; points[3].y=points[1].y;
+  points[4].x=points[3].x+w/6; points[4].y=points[0].y;
+  points[5].x=points[4].x+w/6; points[5].y=points[1].y;
+  dc.drawLines(points,6);
+
+  FXString string="Font: "+p.testFont->getName()+"  Size: "+FXStringVal(p.testFont->getSize()/10);
+  dc.setFont(p.testFont);
+  dc.setForeground(p.forecolor);
+  dc.setBackground(p.backcolor);
+  dc.drawText(30,h-70,string.text(),string.length());
+  dc.drawImageText(30,h-30,string.text(),string.length());
+
+  dc.setFont(p.testFontAngle);
+  dc.drawText(30,h-90,string.text(),string.length());
+  dc.drawImageText(70,h-90,string.text(),string.length());
+  dc.setForeground(FXRGB(0,0,0));
+  dc.fillRectangle(30,h-70,4,4);
+  dc.fillRectangle(30,h-30,4,4);
+  dc.fillRectangle(30,h-90,4,4);
+  dc.fillRectangle(70,h-90,4,4);
+
+
+  dc.setForeground(p.forecolor);
+  dc.setBackground(p.backcolor);
+  dc.drawRectangle(20,20,200,100);
+  dc.fillRectangle(300,20,200,100);
+
+  dc.drawArc(20,120,100,100,64*p.ang1,64*p.ang2);
+  dc.fillArc(200,120,100,100,64*p.ang1,64*p.ang2);
+  dc.fillChord(400,120,100,100,64*p.ang1,64*p.ang2);
+
+  dc.drawRoundRectangle(300,230,100,60, p.cornerw,p.cornerh);
+
+  dc.fillRoundRectangle(420,230,100,60, p.cornerw,p.cornerh);
+
+  FXPoint poly[5];
+  poly[0].x=50;          poly[0].y=230;
+  poly[1].x=poly[0].x+40; poly[1].y=poly[0].y+20;
+  poly[2].x=poly[0].x+30; poly[2].y=poly[0].y+60;
+  poly[3].x=poly[0].x-30; poly[3].y=poly[0].y+60;
+  poly[4].x=poly[0].x-40; poly[4].y=poly[0].y+20;
+  dc.fillPolygon(poly,5);
+
+  poly[0].x=150;          poly[0].y=230;
+  poly[1].x=poly[0].x+30; poly[1].y=poly[0].y+60;
+  poly[2].x=poly[0].x-40; poly[2].y=poly[0].y+20;
+  poly[3].x=poly[0].x+40; poly[3].y=poly[0].y+20;
+  poly[4].x=poly[0].x-30; poly[4].y=poly[0].y+60;
+  dc.fillComplexPolygon(poly,5);
+
+  poly[0].x=250;          poly[0].y=230;
+  poly[1].x=poly[0].x+30; poly[1].y=poly[0].y+60;
+  poly[2].x=poly[0].x-40; poly[2].y=poly[0].y+20;
+  poly[3].x=poly[0].x+40; poly[3].y=poly[0].y+20;
+  poly[4].x=poly[0].x-30; poly[4].y=poly[0].y+60;
+  dc.setFillRule(RULE_WINDING);
+  dc.fillComplexPolygon(poly,5);
+
+  FXPoint concave[4];
+  concave[0].x=w-100; concave[0].y=h-100;
+  concave[1].x=concave[0].x+40; concave[1].y=concave[0].y-20;
+  concave[2].x=concave[0].x;    concave[2].y=concave[0].y+40;
+  concave[3].x=concave[0].x-40; concave[3].y=concave[0].y-20;
+  dc.fillConcavePolygon(concave,4);
+
+  dc.drawEllipse(50,500,100,60);
+  dc.fillEllipse(250,500,100,60);
+
+  // Draw a pale blue dot :-)
+  dc.setForeground(FXRGB(128,128,255));
+  dc.drawPoint(w-20,h-20);
+  }
+
+
+/*******************************************************************************/
+
+
+static void fxClientFXColorToCairoA1(FXuint rows,
+		FXuint fstride, FXColor * f, 
+		FXuint cstride, FXuchar * c,
+		FXuchar alpha_thresh,
+		FXdouble lum_thresh)
+{
+	// Fill a Cairo A1 surface with 1 bit if FXColor alpha >= alpha_thresh,
+	// and its NTSC luminescence is >= lum_thresh.
+	FXuint cols = fstride>>2;
+	FXuchar setbit;
+	for (FXuint row = 0; row < rows; ++row) {
+		for (FXuint i = 0; i < cols; ++i) {
+			if (!(i&7))
+				setbit = 1;
+			else
+				setbit <<= 1;
+			if (FXALPHAVAL(f[i]) >= alpha_thresh &&
+			    FXREDVAL(f[i])*0.3 + FXGREENVAL(f[i])*0.59 + FXBLUEVAL(f[i])*0.11 >= lum_thresh)
+				c[i>>3] |= setbit;
+			else
+				c[i>>3] &= ~setbit;
+		}
+		c += cstride;
+		f += fstride>>2;
+	}
+}
+
+
+
+// Load the images and fonts
+DCScenes::DCScenes(FXApp * a):
+	backfill(FXRGB(255,255,255)),
+	fg(FXRGB(0,0,0)),
+	bg(FXRGB(128,128,128))
+{
+	leaves_250h = new FXPNGImage(a, fall14250h);
+	car_250h = new FXPNGImage(a, car250h);
+	wolf_250h = new FXPNGImage(a, wolf250h);
+	wolf_icon = new FXPNGIcon(a, wolf250h, 0, IMAGE_KEEP);
+	leaves_500w = new FXPNGImage(a, fall14500w);
+	car_500w = new FXPNGImage(a, car500w);
+	wolf_500w = new FXPNGImage(a, wolf500w);
+	tile = new FXPNGImage(a, tile90x90);
+	
+	FXuchar * pix;
+	FXMALLOC(&pix, FXuchar, (wolf_250h->getWidth()+7>>3)*wolf_250h->getHeight());
+	fxClientFXColorToCairoA1(wolf_250h->getHeight(),
+		wolf_250h->getWidth()<<2, wolf_250h->getData(), 
+		wolf_250h->getWidth()+7>>3, pix,
+		128,
+		0);
+	wolf_bits = new FXBitmap(a, pix, BITMAP_KEEP|BITMAP_OWNED, wolf_250h->getWidth(), wolf_250h->getHeight());
+	
+	// FXFont(FXApp* a,const FXString& face,FXuint size,FXuint weight=FXFont::Normal,
+	// FXuint slant=FXFont::Straight,FXuint encoding=FONTENCODING_DEFAULT,
+	// FXuint setwidth=FXFont::NonExpanded,FXuint h=0);
+	font_1 = new FXFont(a, "Helvetica", 30);
+	font_2 = new FXFont(a, "Times", 12);
+	font_3 = new FXFont(a, "Vivaldi", 100, FXFont::Normal, FXFont::Italic);
+}
+
+
+DCScenes::~DCScenes()
+{
+	delete leaves_250h;
+	delete car_250h;
+	delete wolf_250h;
+	delete leaves_500w;
+	delete car_500w;
+	delete wolf_500w;
+	delete wolf_bits;
+	delete wolf_icon;
+	delete tile;
+	delete font_1;
+	delete font_2;
+	delete font_3;
+}
+
+
+// Create images and fonts
+void DCScenes::create()
+{
+	leaves_250h->create();
+	car_250h->create();
+	wolf_250h->create();
+	wolf_icon->create();
+	leaves_500w->create();
+	car_500w->create();
+	wolf_500w->create();
+	wolf_bits->create();
+	tile->create();
+	font_1->create();
+	font_2->create();
+	font_3->create();
+}
+
+
+const char * DCScenes::name(FXuint scene)
+{
+	static const char * names[] = { "stroke", "fill", "image", "text", "clip" };
+	return scene < LAST ? names[scene] : "";
+}
+
+
+void DCScenes::draw(FXuint scene, FXDCWindow & dc, int w, int h)
+{
+	// Test using only the FXDCWindow API
+	dc.setForeground(backfill);
+	dc.fillRectangle(0, 0, w, h);
+	
+	switch (scene) {
+	case STROKE:
+		test_stroke(dc, w, h);
+		break;
+	case FILL:
+		test_fill(dc, w, h);
+		break;
+	case IMAGE:
+		test_image(dc, w, h);
+		break;
+	case TEXT:
+		test_text(dc, w, h);
+		break;
+	case CLIP:
+		test_clip(dc, w, h);
+		break;
+	}
+}
+
+static FXPoint points[13] = {
+	{ 5, 0},
+	{ 5, 6},
+	{ 8, 2},
+	{ 2, 2},
+	{ 2, 3},
+	{ 6, 3},
+	{ 6, 4},
+	{ 4, 4},
+	{ 4, 0},
+	{ 0, 4},
+	{ 1, 1},
+	{ 2, 6},
+	{ 5, 0},
+};
+
+void DCScenes::test_stroke(FXDCWindow & dc, int w, int h)
+{
+	// Test drawing points, lines, rectangles, arcs.
+	FXuint i, j;
+	FXint x, y, xx, yy;
+	FXPoint p[13];
+	FXArc arcs[4];
+/*
+	virtual void setForeground(FXColor clr);
+	virtual void setBackground(FXColor clr);
+	virtual void setDashes(FXuint dashoffset,const FXchar *dashpattern,FXuint dashlength);
+	virtual void setLineWidth(FXuint linewidth=0);
+	virtual void setLineCap(FXCapStyle capstyle=CAP_BUTT);
+	virtual void setLineJoin(FXJoinStyle joinstyle=JOIN_MITER);
+	virtual void setLineStyle(FXLineStyle linestyle=LINE_SOLID);
+	
+	virtual void drawPoint(FXint x,FXint y);
+	virtual void drawPoints(const FXPoint* points,FXuint npoints);
+	virtual void drawPointsRel(const FXPoint* points,FXuint npoints);
+	virtual void drawLine(FXint x1,FXint y1,FXint x2,FXint y2);
+	virtual void drawLines(const FXPoint* points,FXuint npoints);
+	virtual void drawLinesRel(const FXPoint* points,FXuint npoints);
+	virtual void drawLineSegments(const FXSegment* segments,FXuint nsegments);
+	virtual void drawRectangle(FXint x,FXint y,FXint w,FXint h);
+	virtual void drawRectangles(const FXRectangle* rectangles,FXuint nrectangles);
+	virtual void drawRoundRectangle(FXint x,FXint y,FXint w,FXint h,FXint ew,FXint eh);
+	virtual void drawArc(FXint x,FXint y,FXint w,FXint h,FXint ang1,FXint ang2);
+	virtual void drawArcs(const FXArc* arcs,FXuint narcs);
+	virtual void drawEllipse(FXint x,FXint y,FXint w,FXint h);
+*/
+	dc.setForeground(fg);
+	dc.setBackground(bg);
+	for (i = 0; i < 10; ++i) {
+		x = 10;
+		y = 10 + i*20;
+		xx = 100;
+		yy = y + i*3;
+		dc.setLineWidth(i);
+		dc.drawLine(x, y, xx, yy);
+	}
+	dc.setLineCap(CAP_ROUND);
+	for (i = 0; i < 10; ++i) {
+		x = 220;
+		y = 10 + i*20;
+		xx = 110;
+		yy = y + i*3;
+		dc.setLineWidth(i);
+		dc.drawLine(x, y, xx, yy);
+	}
+	dc.setLineCap(CAP_PROJECTING);
+	for (i = 0; i < 10; ++i) {
+		x = 10+i*20;
+		y = 250;
+		xx = x - i*2;
+		yy = 350;
+		dc.setLineWidth(i);
+		dc.drawLine(x, y, xx, yy);
+	}
+	dc.setLineWidth(10);
+	dc.setLineCap(CAP_ROUND);
+	for (i = 0; i < 12; ++i)
+		p[i] = points[i]*20 + FXPoint(250, 20);
+	for (i = 0; i < 3; ++i) {
+		dc.setLineJoin(i==0?JOIN_MITER:i==1?JOIN_ROUND:JOIN_BEVEL);
+		dc.drawLines(p, 12);
+		for (j = 0; j < 12; ++j)
+			p[j] += FXPoint(0, 150);
+	}
+	for (i = 0; i < 13; ++i)
+		p[i] = points[i]*20 + FXPoint(400, 20);
+	// As above, but 1st and last points the same, to close path
+	for (i = 0; i < 3; ++i) {
+		dc.setLineJoin(i==0?JOIN_MITER:i==1?JOIN_ROUND:JOIN_BEVEL);
+		dc.drawLines(p, 13);
+		for (j = 0; j < 13; ++j)
+			p[j] += FXPoint(0, 150);
+	}
+	
+	for (i = 0; i < 12; ++i)
+		p[i] = points[i]*20 + FXPoint(550, 20);
+	dc.drawPoints(p, 13);
+	
+	for (i = 0; i < 12; ++i)
+		p[i] += FXPoint(0, 150);
+	dc.drawLineSegments((const FXSegment*)p, 6);
+	for (i = 0; i < 12; ++i)
+		p[i] += FXPoint(0, 150);
+	dc.setLineCap(CAP_PROJECTING);
+	dc.drawLineSegments((const FXSegment*)p, 6);
+	
+	dc.setLineJoin(JOIN_MITER);
+	for (i = 0; i < 4; ++i) {
+		dc.setLineWidth(i*3+1);
+		dc.drawRectangle(700+i*20, 20+i*20, 100, 50);
+	}
+	dc.drawHashBox(700+i*20, 20+i*20, 100, 50, 6);
+	++i;
+	dc.drawFocusRectangle(700+i*20, 20+i*20, 100, 50);
+	for (i = 0; i < 4; ++i) {
+		dc.setLineWidth(i*3+1);
+		dc.drawRoundRectangle(700+i*20, 200+i*40, 100, 50, 20, 20);
+	}
+	
+	for (i = 0; i < 4; ++i) {
+		arcs[i].x = 900;
+		arcs[i].y = 20 + i*100;
+		arcs[i].w = 100;
+		arcs[i].h = 80;
+	}
+	arcs[0].a = 64 * 45; arcs[0].b = 64 * 270;
+	arcs[1].a = 64 * 45; arcs[1].b = 64 * -270;
+	arcs[2].a = 64 * -30; arcs[2].b = 64 * 270;
+	arcs[3].a = 64 * -30; arcs[3].b = 64 * -270;
+	dc.setLineCap(CAP_BUTT);
+	dc.setLineWidth(4);
+	dc.drawArcs(arcs, 4);
+	
+	for (i = 0; i < 4; ++i) {
+		dc.drawEllipse(1020, 20+i*100, 100-i*20, 20+i*20);
+	}
+	
+	dc.setLineWidth(10);
+	dc.setLineCap(CAP_BUTT);
+	FXchar dd[2];
+	dd[0] = 20;
+	dd[1] = 10;
+	dc.setDashes(0, dd, 2);
+	dc.setLineStyle(LINE_ONOFF_DASH);
+	for (i = 0; i < 12; ++i)
+		p[i] = points[i]*20 + FXPoint(1150, 20);
+	for (i = 0; i < 3; ++i) {
+		dc.setLineJoin(i==0?JOIN_MITER:i==1?JOIN_ROUND:JOIN_BEVEL);
+		if (i == 1)
+			dc.setLineStyle(LINE_DOUBLE_DASH);
+		if (i == 2)
+			dc.setLineStyle(LINE_ONOFF_DASH);
+		dc.drawLines(p, 12);
+		for (j = 0; j < 12; ++j)
+			p[j] += FXPoint(0, 150);
+	}
+
+	
+}
+
+void DCScenes::test_fill(FXDCWindow & dc, int w, int h)
+{
+	FXuint i, j;
+	FXint x, y, xx, yy;
+	FXPoint p[13];
+	FXArc arcs[4];
+/*
+	virtual void setForeground(FXColor clr);
+	virtual void setFillStyle(FXFillStyle fillstyle=FILL_SOLID);
+  FILL_SOLID,                     /// Fill with solid color
+  FILL_TILED,                     /// Fill with tiled bitmap
+  FILL_STIPPLED,                  /// Fill where stipple mask is 1
+  FILL_OPAQUESTIPPLED             /// Fill with foreground where mask is 1, background otherwise
+	virtual void setFillRule(FXFillRule fillrule=RULE_EVEN_ODD);
+	virtual void setFunction(FXFunction func=BLT_SRC);
+	virtual void setTile(FXImage* tile,FXint dx=0,FXint dy=0);
+	virtual void setStipple(FXBitmap *stipple,FXint dx=0,FXint dy=0);
+	virtual void setStipple(FXStipplePattern stipple,FXint dx=0,FXint dy=0);
+
+	virtual void fillRectangle(FXint x,FXint y,FXint w,FXint h);
+	virtual void fillRectangles(const FXRectangle* rectangles,FXuint nrectangles);
+	virtual void fillRoundRectangle(FXint x,FXint y,FXint w,FXint h,FXint ew,FXint eh);
+	virtual void fillChord(FXint x,FXint y,FXint w,FXint h,FXint ang1,FXint ang2);
+	virtual void fillChords(const FXArc* chords,FXuint nchords);
+	virtual void fillArc(FXint x,FXint y,FXint w,FXint h,FXint ang1,FXint ang2);
+	virtual void fillArcs(const FXArc* arcs,FXuint narcs);
+	virtual void fillEllipse(FXint x,FXint y,FXint w,FXint h);
+	virtual void fillComplexPolygon(const FXPoint* points,FXuint npoints);
+	virtual void fillComplexPolygonRel(const FXPoint* points,FXuint npoints);
+*/
+	dc.setTile(tile, 0, 0);
+	dc.setFillStyle(FILL_TILED);
+	dc.fillRectangle(0, 0, w, h);
+	dc.setFillStyle(FILL_SOLID);
+
+	dc.setForeground(fg);
+	dc.setBackground(bg);
+
+	for (i = 0; i < 4; ++i) {
+		dc.setForeground(i & 1 ? fg : bg);
+		dc.fillRectangle(20+i*20, 20+i*20, 100, 50);
+	}
+	for (i = 0; i < 4; ++i) {
+		dc.setForeground(i & 1 ? bg : fg);
+		dc.fillRoundRectangle(20+i*20, 200+i*40, 100, 50, 20, 20);
+	}
+	
+	dc.setForeground(fg);
+	for (i = 0; i < 4; ++i) {
+		arcs[i].x = 200;
+		arcs[i].y = 20 + i*100;
+		arcs[i].w = 100;
+		arcs[i].h = 80;
+	}
+	arcs[0].a = 64 * 45; arcs[0].b = 64 * 270;
+	arcs[1].a = 64 * 45; arcs[1].b = 64 * -270;
+	arcs[2].a = 64 * -30; arcs[2].b = 64 * 270;
+	arcs[3].a = 64 * -30; arcs[3].b = 64 * -270;
+	dc.fillChords(arcs, 4);
+	for (i = 0; i < 4; ++i)
+		arcs[i].x = 400;
+	dc.fillArcs(arcs, 4);
+	
+	for (i = 0; i < 4; ++i) {
+		dc.fillEllipse(600, 20+i*100, 100-i*20, 20+i*20);
+	}
+
+	for (i = 0; i < 12; ++i)
+		p[i] = points[i]*20 + FXPoint(800, 20);
+	for (i = 0; i < 2; ++i) {
+		dc.setFillRule(i==0?RULE_EVEN_ODD:RULE_WINDING);
+		dc.fillComplexPolygon(p, 12);
+		for (j = 0; j < 12; ++j)
+			p[j] += FXPoint(0, 150);
+	}
+	
+	
+}
+
+void DCScenes::test_image(FXDCWindow & dc, int w, int h)
+{
+/*
+	virtual void drawArea(const FXDrawable* source,FXint sx,FXint sy,
+			FXint sw,FXint sh,FXint dx,FXint dy);
+	virtual void drawArea(const FXDrawable* source,FXint sx,FXint sy,
+			FXint sw,FXint sh,FXint dx,FXint dy,FXint dw,FXint dh);
+	virtual void drawImage(const FXImage* image,FXint dx,FXint dy);
+	virtual void drawBitmap(const FXBitmap* bitmap,FXint dx,FXint dy);
+	virtual void drawIcon(const FXIcon* icon,FXint dx,FXint dy);
+	virtual void drawIconShaded(const FXIcon* icon,FXint dx,FXint dy);
+	virtual void drawIconSunken(const FXIcon* icon,FXint dx,FXint dy);
+	virtual void drawText(FXint x,FXint y,const FXString& string);
+	virtual void drawText(FXint x,FXint y,const FXchar* string,FXuint length);
+	virtual void drawImageText(FXint x,FXint y,const FXString& string);
+	virtual void drawImageText(FXint x,FXint y,const FXchar* string,FXuint length);
+*/
+	dc.setForeground(fg);
+	dc.setBackground(bg);
+	dc.drawImage(leaves_250h, 0, 0);
+	dc.drawArea(leaves_250h, 0, 0, leaves_250h->getWidth(), leaves_250h->getHeight(), 
+		0, 250, leaves_250h->getWidth(), leaves_250h->getHeight()/3);
+	#ifdef CAR
+	dc.drawArea(car_250h, 0, 0, car_250h->getWidth(), car_250h->getHeight(), 
+		400, 0, car_250h->getWidth(), car_250h->getHeight());
+	dc.drawArea(car_250h, 50, 50, car_250h->getWidth()-100, car_250h->getHeight()-100, 
+		400, 250, car_250h->getWidth(), car_250h->getHeight());
+	#else
+	dc.drawIcon(wolf_icon, 400,0);
+	dc.drawIconShaded(wolf_icon, 400,250);
+	dc.drawIconSunken(wolf_icon, 600,0);
+	#endif
+	dc.drawArea(wolf_250h, 0, 0, wolf_250h->getWidth(), wolf_250h->getHeight(),
+		1000, 0);
+	//dc.drawArea(wolf_250h, 50, 50, wolf_250h->getWidth(), wolf_250h->getHeight(),
+	//	1000, 250);
+	dc.drawBitmap(wolf_bits, 1000, 250);
+}
+
+
+void DCScenes::test_text(FXDCWindow & dc, int w, int h)
+{
+	dc.setForeground(fg);
+	dc.setBackground(bg);
+	dc.setFont(font_1);
+	dc.setLineWidth(0);
+	FXuint x = 30;
+	FXuint y = 60;
+	dc.drawLine(x-10, y, x, y);
+	dc.drawText(x, y, "Hello World", 11);
+	y = 100;
+	dc.setFont(font_2);
+	FXString s("This is an example of longer\ntext split over several\nlines using \u03a0\u03b1\u03bd\u8a9e");
+	dc.drawText(x, y, s);
+	y = 400;
+	dc.setFont(font_3);
+	dc.setTile(tile, 0, 0);
+	dc.setFillStyle(FILL_TILED);
+	s = "Fancy Stuff in \u03a0\u03b1\u03bd\u8a9e!";
+	dc.drawImageText(x, y, s);
+	x = 400;
+	y = 30;
+	dc.setFont(font_1);
+	dc.setFillStyle(FILL_SOLID);
+	dc.setForeground(FXRGB(0,0,180));
+	s = "Pango (\u03a0\u03b1\u03bd\u8a9e) is a text layout\n"
+	    "engine library which works with\n"
+	    "HarfBuzz shaping engine for\n"
+	    "displaying multi-language text.";
+	dc.drawImageText(x, y, s);
+}
+
+void DCScenes::test_clip(FXDCWindow & dc, int w, int h)
+{
+	dc.setClipMask(wolf_bits, 30, 30);
+	dc.setForeground(fg);
+	dc.setBackground(bg);
+	dc.setFont(font_2);
+	FXString s(
+"Running, hunting, trying, surviving, and dying.\n"
+"The wolves have no home anymore, thats why thery are crying.\n"
+"For miles and miles howls are heard discussing their fates.\n"
+"Humans don't care for this animal; wolves are forgotten then killed.\n"
+"Humans don't know that a wolf has no hates.\n"
+"That's why a wolf doesn't end up at Hell's gates.\n"
+"Dark night color blue; wolves' images are relived on 14 Karat gold plates.\n"
+"The round moon is the only light that they see.\n"
+"Humans keep on destroying a beautiful home.\n"
+"Wolves aren't dumb; they know they have no place to roam.\n"
+"At night is the call of the wild.\n"
+"Something pure on this Earth; like a new born child.\n"
+"Cool air, water, and snow once demolished their fears.\n"
+"There is nothing out there anymore; nothing but tears.\n"
+"An innocent dream, turned black in the darkest clear...\n"
+"For fire now dwells on the western land.\n"
+"A newborn wolf pup sees his life has been altered.\n"
+"No soft land to comfort your paws-only land of concrete and people.\n"
+"Civilization to you.\n"
+"No home no hope No life, but great sadness and fear.\n"
+"Why can't the kingdom of salvation take them home.\n"
+"-Anonymous");
+	dc.drawImageText(30, 30, s);
+
+}
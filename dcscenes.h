@@ -0,0 +1,107 @@
+/********************************************************************************
+*                                                                               *
+*         Test scenes shared by dctest, dctest2 and scenebench                  *
+*                                                                               *
+********************************************************************************/
+#ifndef DCSCENES_H
+#define DCSCENES_H
+
+/*
+	The scenes only use the FXDC API, so they can be drawn with FXDCWindow,
+	FXDCCairo or any of its subclasses.  Include after fx.h.
+*/
+
+// Image data from images.cpp (generated by reswrap)
+extern const unsigned char car250h[];
+extern const unsigned char car500w[];
+extern const unsigned char fall14250h[];
+extern const unsigned char fall14500w[];
+extern const unsigned char tile90x90[];
+extern const unsigned char wolf250h[];
+extern const unsigned char wolf500w[];
+
+
+// Drawing parameters for the dctest page
+struct DCPage {
+	FXFunction         function;        // BLIT function
+	FXLineStyle        lineStyle;       // Line style
+	FXCapStyle         capStyle;        // Cap style
+	FXJoinStyle        joinStyle;       // Join style
+	FXFillStyle        fillStyle;       // Filling style
+	FXColor            forecolor;       // Foreground color
+	FXColor            backcolor;       // Background color
+	FXColor            erasecolor;      // Canvas erased color
+	FXStipplePattern   stipple;         // Stipple pattern
+	FXuint             lineWidth;       // Line width
+	FXImage           *textureImage;    // Texture image
+	FXFont            *testFont;        // Test font
+	FXFont            *testFontAngle;   // Test font at angle
+	FXint              ang1;            // Arc angle 1
+	FXint              ang2;            // Arc angle 2
+	FXint              cornerw;         // Corner width
+	FXint              cornerh;         // Corner height
+};
+
+
+// The dctest page.  This is the WYSIWYG routine, it takes a DC and renders
+// into it; it does not know if the DC is a printer or screen.
+extern void drawPageScene(FXDC& dc,FXint w,FXint h,const DCPage& p);
+
+
+// Images, fonts and colours for the dctest2 scenes
+class DCScenes
+{
+public:
+	enum {
+		STROKE,
+		FILL,
+		IMAGE,
+		TEXT,
+		CLIP,
+		LAST
+	};
+
+	FXColor backfill;
+	FXColor fg;
+	FXColor bg;
+
+	FXImage * leaves_250h;
+	FXImage * car_250h;
+	FXImage * wolf_250h;
+	FXImage * leaves_500w;
+	FXImage * car_500w;
+	FXImage * wolf_500w;
+	FXBitmap * wolf_bits;
+	FXIcon * wolf_icon;
+	FXImage * tile;
+
+	FXFont * font_1;
+	FXFont * font_2;
+	FXFont * font_3;
+
+private:
+	DCScenes(const DCScenes&);
+	DCScenes &operator=(const DCScenes&);
+
+public:
+	DCScenes(FXApp * a);
+
+	// Create images and fonts
+	void create();
+
+	// Clear to backfill, then draw scene (STROKE etc.) in w x h
+	void draw(FXuint scene, FXDCWindow & dc, int w, int h);
+
+	void test_stroke(FXDCWindow & dc, int w, int h);
+	void test_fill(FXDCWindow & dc, int w, int h);
+	void test_image(FXDCWindow & dc, int w, int h);
+	void test_text(FXDCWindow & dc, int w, int h);
+	void test_clip(FXDCWindow & dc, int w, int h);
+
+	// Name of scene, e.g. "stroke"
+	static const char * name(FXuint scene);
+
+	~DCScenes();
+};
+
+#endif
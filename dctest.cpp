@@ -16,7 +16,7 @@
 
 #include "FXPNGImage.h"
 #include "FXPNGIcon.h"
-#include "images.cpp"
+#include "dcscenes.h"
 
 
 /* Generated by reswrap from file double_dash.gif */
@@ -1354,105 +1354,27 @@ long DCTestWindow::onPaintImages(FXObject *sender,FXSelector,void *ptr){
   }
 
 
-// This is the WYSIWYG routine, it takes a DC and renders
-// into it; it does not know if the DC is a printer or screen.
+// Draw page; the scene is shared with scenebench
 void DCTestWindow::drawPage(FXDC& dc,FXint w,FXint h){
-
-  dc.setForeground(erasecolor);
-  dc.fillRectangle(0,0,w,h);
-
-  dc.setForeground(forecolor);
-  dc.setBackground(backcolor);
-
-  dc.setLineStyle(lineStyle);
-  dc.setLineCap(capStyle);
-  dc.setLineJoin(joinStyle);
-  dc.setFunction(function);
-
-  dc.setStipple(stipple);
-  dc.setFillStyle(fillStyle);
-  dc.setLineWidth(lineWidthSpinner->getValue());
-  dc.setTile(textureImage);
-
-  // Here's a single line
-  dc.drawLine(20,200,w-20,200);
-
-  // Here are some connected lines (to show join styles)
-  FXPoint points[6];
-  points[0].x=10;              points[0].y=3*h/4;
-  points[1].x=points[0].x+w/6; points[1].y=h/2;
-  points[2].x=points[1].x+w/6; points[2].y=points[0].y;
-  points[3].x=points[2].x+w/6; points[3].y=points[1].y;
-  points[4].x=points[3].x+w/6; points[4].y=points[0].y;
-  points[5].x=points[4].x+w/6; points[5].y=points[1].y;
-  dc.drawLines(points,6);
-
-  FXString string="Font: "+testFont->getName()+"  Size: "+FXStringVal(testFont->getSize()/10);
-  dc.setFont(testFont);
-  dc.setForeground(forecolor);
-  dc.setBackground(backcolor);
-  dc.drawText(30,h-70,string.text(),string.length());
-  dc.drawImageText(30,h-30,string.text(),string.length());
-
-  dc.setFont(testFontAngle);
-  dc.drawText(30,h-90,string.text(),string.length());
-  dc.drawImageText(70,h-90,string.text(),string.length());
-  dc.setForeground(FXRGB(0,0,0));
-  dc.fillRectangle(30,h-70,4,4);
-  dc.fillRectangle(30,h-30,4,4);
-  dc.fillRectangle(30,h-90,4,4);
-  dc.fillRectangle(70,h-90,4,4);
-
-
-  dc.setForeground(forecolor);
-  dc.setBackground(backcolor);
-  dc.drawRectangle(20,20,200,100);
-  dc.fillRectangle(300,20,200,100);
-
-  dc.drawArc(20,120,100,100,64*ang1,64*ang2);
-  dc.fillArc(200,120,100,100,64*ang1,64*ang2);
-  dc.fillChord(400,120,100,100,64*ang1,64*ang2);
-
-  dc.drawRoundRectangle(300,230,100,60, cornerw,cornerh);
-
-  dc.fillRoundRectangle(420,230,100,60, cornerw,cornerh);
-
-  FXPoint poly[5];
-  poly[0].x=50;          poly[0].y=230;
-  poly[1].x=poly[0].x+40; poly[1].y=poly[0].y+20;
-  poly[2].x=poly[0].x+30; poly[2].y=poly[0].y+60;
-  poly[3].x=poly[0].x-30; poly[3].y=poly[0].y+60;
-  poly[4].x=poly[0].x-40; poly[4].y=poly[0].y+20;
-  dc.fillPolygon(poly,5);
-
-  poly[0].x=150;          poly[0].y=230;
-  poly[1].x=poly[0].x+30; poly[1].y=poly[0].y+60;
-  poly[2].x=poly[0].x-40; poly[2].y=poly[0].y+20;
-  poly[3].x=poly[0].x+40; poly[3].y=poly[0].y+20;
-  poly[4].x=poly[0].x-30; poly[4].y=poly[0].y+60;
-  dc.fillComplexPolygon(poly,5);
-
-  poly[0].x=250;          poly[0].y=230;
-  poly[1].x=poly[0].x+30; poly[1].y=poly[0].y+60;
-  poly[2].x=poly[0].x-40; poly[2].y=poly[0].y+20;
-  poly[3].x=poly[0].x+40; poly[3].y=poly[0].y+20;
-  poly[4].x=poly[0].x-30; poly[4].y=poly[0].y+60;
-  dc.setFillRule(RULE_WINDING);
-  dc.fillComplexPolygon(poly,5);
-
-  FXPoint concave[4];
-  concave[0].x=w-100; concave[0].y=h-100;
-  concave[1].x=concave[0].x+40; concave[1].y=concave[0].y-20;
-  concave[2].x=concave[0].x;    concave[2].y=concave[0].y+40;
-  concave[3].x=concave[0].x-40; concave[3].y=concave[0].y-20;
-  dc.fillConcavePolygon(concave,4);
-
-  dc.drawEllipse(50,500,100,60);
-  dc.fillEllipse(250,500,100,60);
-
-  // Draw a pale blue dot :-)
-  dc.setForeground(FXRGB(128,128,255));
-  dc.drawPoint(w-20,h-20);
+  DCPage p;
+  p.function=function;
+  p.lineStyle=lineStyle;
+  p.capStyle=capStyle;
+  p.joinStyle=joinStyle;
+  p.fillStyle=fillStyle;
+  p.forecolor=forecolor;
+  p.backcolor=backcolor;
+  p.erasecolor=erasecolor;
+  p.stipple=stipple;
+  p.lineWidth=lineWidthSpinner->getValue();
+  p.textureImage=textureImage;
+  p.testFont=testFont;
+  p.testFontAngle=testFontAngle;
+  p.ang1=ang1;
+  p.ang2=ang2;
+  p.cornerw=cornerw;
+  p.cornerh=cornerh;
+  drawPageScene(dc,w,h,p);
   }
 
 
@@ -0,0 +1,148 @@
+/********************************************************************************
+*                                                                               *
+*        Micro-benchmark for the FOX to Cairo pixel conversion kernels          *
+*                                                                               *
+********************************************************************************/
+#include "fx.h"
+#include "FXCairoPixels.h"
+
+/*
+	Times each conversion in FXCairoPixels.h with every kernel set the CPU
+	supports, after checking that the result is bit-identical to the scalar
+	version.  Then times each conversion with the best kernels, split over
+	1, 2, 4, 8 and 16 threads, checking the result against one thread.  Does
+	not need a display.  Output is one line per test:
+
+		<test> <kernels> <width>x<height> <Mpixel/s> <ns/pixel>
+
+	where kernels is scalar, sse2 or avx2, or threads-<n> for the threaded runs.
+
+	Usage: pixbench [width [height [iterations]]]
+*/
+
+static const char * kernelNames[] = { "scalar", "sse2", "avx2" };
+
+enum {
+	TEST_ARGB32,
+	TEST_ARGB32_KEY,
+	TEST_A8,
+	TEST_A1_KEY,
+	TEST_LAST
+};
+
+static const char * testNames[] = { "argb32", "argb32-key", "a8", "a1-key" };
+
+
+// Simple LCG, so runs are repeatable
+static FXuint rnd()
+{
+	static FXuint seed = 12345;
+	seed = seed*1103515245 + 12345;
+	return seed;
+}
+
+
+static void runTest(int test, const FXColor * src, FXuint w, FXuint h,
+		FXuchar * dst, FXuint cstride, FXColor transparent)
+{
+	switch (test) {
+	case TEST_ARGB32:
+		fxClientFXColorToCairoARGB32(h, w<<2, src, cstride, (FXuint *)dst);
+		break;
+	case TEST_ARGB32_KEY:
+		fxClientFXColorTransparencyToCairoARGB32(h, w<<2, src, cstride, (FXuint *)dst, transparent);
+		break;
+	case TEST_A8:
+		fxClientFXColorToCairoA8(h, w<<2, src, cstride, dst);
+		break;
+	case TEST_A1_KEY:
+		fxClientFXColorToCairoA1(h, w<<2, src, cstride, dst, transparent);
+		break;
+	}
+}
+
+
+int main(int argc,char *argv[])
+{
+	FXuint w = argc > 1 ? atoi(argv[1]) : 1920;
+	FXuint h = argc > 2 ? atoi(argv[2]) : 1080;
+	FXuint iters = argc > 3 ? atoi(argv[3]) : 50;
+	FXuint best = fxCairoPixelKernelsAvailable();
+	FXuint cstride = w<<2;
+	FXColor transparent = FXRGB(255,0,255);
+	FXColor * src;
+	FXuchar * ref;
+	FXuchar * dst;
+	FXMALLOC(&src, FXColor, w*h);
+	FXMALLOC(&ref, FXuchar, cstride*h);
+	FXMALLOC(&dst, FXuchar, cstride*h);
+
+	// Mixture of opaque, transparent, partial alpha and colour-keyed pixels
+	for (FXuint i = 0; i < w*h; ++i) {
+		FXuint r = rnd();
+		switch (r>>28) {
+		case 0: src[i] = transparent; break;
+		case 1: src[i] = r & 0x00FFFFFF; break;
+		case 2: case 3: src[i] = r; break;
+		default: src[i] = r | 0xFF000000; break;
+		}
+	}
+
+	int failed = 0;
+	fxCairoSetPixelThreads(1);
+	for (int test = 0; test < TEST_LAST; ++test) {
+		fxCairoSetPixelKernels(FXCAIRO_PIXELS_SCALAR);
+		memset(ref, 0, cstride*h);
+		runTest(test, src, w, h, ref, cstride, transparent);
+		for (FXuint k = FXCAIRO_PIXELS_SCALAR; k <= best; ++k) {
+			fxCairoSetPixelKernels(k);
+			memset(dst, 0, cstride*h);
+			runTest(test, src, w, h, dst, cstride, transparent);
+			if (memcmp(ref, dst, cstride*h)) {
+				printf("%s %s MISMATCH\n", testNames[test], kernelNames[k]);
+				failed = 1;
+				continue;
+			}
+			FXTime t0 = FXThread::time();
+			for (FXuint n = 0; n < iters; ++n)
+				runTest(test, src, w, h, dst, cstride, transparent);
+			FXTime t1 = FXThread::time();
+			double ns = (double)(t1 - t0)/((double)iters*w*h);
+			printf("%s %s %ux%u %.1f %.3f\n", testNames[test], kernelNames[k], w, h,
+				1000./ns, ns);
+		}
+	}
+
+	// Threads, with the best kernels, splitting any size of image
+	static const FXuint threads[] = { 1, 2, 4, 8, 16 };
+	fxCairoSetPixelKernels(best);
+	fxCairoSetPixelParallelThreshold(0);
+	for (int test = 0; test < TEST_LAST; ++test) {
+		fxCairoSetPixelThreads(1);
+		memset(ref, 0, cstride*h);
+		runTest(test, src, w, h, ref, cstride, transparent);
+		for (FXuint t = 0; t < ARRAYNUMBER(threads); ++t) {
+			fxCairoSetPixelThreads(threads[t]);
+			memset(dst, 0, cstride*h);
+			runTest(test, src, w, h, dst, cstride, transparent);
+			if (memcmp(ref, dst, cstride*h)) {
+				printf("%s threads-%u MISMATCH\n", testNames[test], threads[t]);
+				failed = 1;
+				continue;
+			}
+			FXTime t0 = FXThread::time();
+			for (FXuint n = 0; n < iters; ++n)
+				runTest(test, src, w, h, dst, cstride, transparent);
+			FXTime t1 = FXThread::time();
+			double ns = (double)(t1 - t0)/((double)iters*w*h);
+			printf("%s threads-%u %ux%u %.1f %.3f\n", testNames[test], threads[t], w, h,
+				1000./ns, ns);
+		}
+	}
+	fxCairoSetPixelThreads(1);
+
+	FXFREE(&src);
+	FXFREE(&ref);
+	FXFREE(&dst);
+	return failed;
+}
@@ -0,0 +1,242 @@
+/********************************************************************************
+*                                                                               *
+*       Benchmark of the dctest/dctest2 scenes with FXDCWindow and FXDCCairo    *
+*                                                                               *
+********************************************************************************/
+#include "xincs_cairo.h"
+#include "fx.h"
+#include "FXDCCairo.h"
+#include "FXDCCairoImage.h"
+#include "dcscenes.h"
+
+/*
+	Draws each of the dctest2 scenes (stroke, fill, image, text, clip) and
+	the dctest page into an off-screen FXImage with FXDCWindow and FXDCCairo,
+	and into client memory with FXDCCairoImage.  Not interactive, and needs no
+	window manager (Xvfb will do).  Output is one line per measurement:
+
+		<scene> <dc> <reps> <ops/s> <ns/op> <allocs/op>
+
+	where an op is one drawing of the whole scene on a new DC, and allocs/op is
+	the number of calls to malloc(), calloc() and realloc() by the program and
+	the libraries it uses (-1 where it can't be counted).  Time includes a
+	round trip to the X server at the end, so the server's share of the work
+	is counted for the DC's which use it.
+
+	If the library was configured with --enable-instrument, each line is
+	followed on stderr by the FXDCCairo operations used in the timed runs.
+
+	Usage: scenebench [-r reps] [scene...] [dc...]
+	Scenes are stroke, fill, image, text, clip and page; dc's are window,
+	cairo and cairo-image.  With none given, runs all of them.
+*/
+
+#define TARGET_W 1300
+#define TARGET_H 800
+
+
+/*******************************************************************************/
+
+// Allocation counting.  With glibc, the program can define malloc() and
+// friends itself and pass the calls on; the shared libraries use ours.
+
+#if defined(__GLIBC__)
+
+static volatile unsigned long allocCount;
+
+extern "C" {
+
+extern void * __libc_malloc(size_t n);
+extern void * __libc_calloc(size_t n, size_t s);
+extern void * __libc_realloc(void * p, size_t n);
+
+void * malloc(size_t n) throw()
+{
+	__sync_fetch_and_add(&allocCount, 1);
+	return __libc_malloc(n);
+}
+
+void * calloc(size_t n, size_t s) throw()
+{
+	__sync_fetch_and_add(&allocCount, 1);
+	return __libc_calloc(n, s);
+}
+
+void * realloc(void * p, size_t n) throw()
+{
+	__sync_fetch_and_add(&allocCount, 1);
+	return __libc_realloc(p, n);
+}
+
+}
+
+static long allocations() { return (long)allocCount; }
+
+#else
+
+static long allocations() { return -1; }
+
+#endif
+
+
+/*******************************************************************************/
+
+static FXApp * app;
+static FXImage * target;
+static FXuchar * pixels;
+static DCScenes * scenes;
+static DCPage page;
+
+enum {
+	DC_WINDOW,
+	DC_CAIRO,
+	DC_CAIRO_IMAGE,
+	DC_LAST
+};
+
+static const char * dcNames[] = { "window", "cairo", "cairo-image" };
+
+#define SCENE_PAGE DCScenes::LAST
+
+
+static const char * sceneName(FXuint scene)
+{
+	return scene == SCENE_PAGE ? "page" : DCScenes::name(scene);
+}
+
+
+// Draw scene once on dc
+static void drawScene(FXuint scene, FXDCWindow & dc)
+{
+	if (scene == SCENE_PAGE)
+		drawPageScene(dc, TARGET_W, TARGET_H, page);
+	else
+		scenes->draw(scene, dc, TARGET_W, TARGET_H);
+}
+
+
+// Draw scene once on a new DC of the given kind
+static void drawOnce(FXuint scene, FXuint kind)
+{
+	switch (kind) {
+	case DC_WINDOW: {
+		FXDCWindow dc(target);
+		drawScene(scene, dc);
+		break;
+	}
+	case DC_CAIRO: {
+		FXDCCairo dc(target);
+		drawScene(scene, dc);
+		break;
+	}
+	case DC_CAIRO_IMAGE: {
+		FXDCCairoImage dc(app, pixels, TARGET_W, TARGET_H, FXDCCairoImage::getStride(TARGET_W));
+		drawScene(scene, dc);
+		break;
+	}
+	}
+}
+
+
+static void bench(FXuint scene, FXuint kind, FXuint reps)
+{
+	// Warm up caches
+	drawOnce(scene, kind);
+	app->flush(TRUE);
+	FXDCCairo::resetGlobalOpStats();
+	long a0 = allocations();
+	FXTime t0 = FXThread::time();
+	for (FXuint r = 0; r < reps; ++r)
+		drawOnce(scene, kind);
+	app->flush(TRUE);
+	FXTime t1 = FXThread::time();
+	long a1 = allocations();
+	double ns = (double)(t1 - t0)/reps;
+	printf("%s %s %u %.1f %.0f %ld\n", sceneName(scene), dcNames[kind], reps, 1.e9/ns, ns,
+		a0 < 0 ? -1L : (long)((a1 - a0)/reps));
+	fflush(stdout);
+	if (FXDCCairo::isInstrumented()) {
+		FXCairoOpStats stats;
+		FXDCCairo::getGlobalOpStats(stats);
+		FXDCCairo::dumpOpStats(stats, stderr);
+	}
+}
+
+
+// Here we begin
+int main(int argc,char *argv[])
+{
+	FXApp application("SceneBench","FoxTest");
+	application.init(argc,argv);
+	app = &application;
+
+	FXuint reps = 20;
+	FXbool wantScene[SCENE_PAGE+1];
+	FXbool wantDC[DC_LAST];
+	FXbool anyScene = FALSE;
+	FXbool anyDC = FALSE;
+	memset(wantScene, 0, sizeof(wantScene));
+	memset(wantDC, 0, sizeof(wantDC));
+	for (int a = 1; a < argc; ++a) {
+		if (!strcmp(argv[a], "-r") && a+1 < argc) {
+			reps = FXMAX(1, atoi(argv[++a]));
+			continue;
+		}
+		FXbool known = FALSE;
+		for (FXuint s = 0; s <= SCENE_PAGE; ++s)
+			if (!strcmp(argv[a], sceneName(s)))
+				wantScene[s] = anyScene = known = TRUE;
+		for (FXuint k = 0; k < DC_LAST; ++k)
+			if (!strcmp(argv[a], dcNames[k]))
+				wantDC[k] = anyDC = known = TRUE;
+		if (!known) {
+			fprintf(stderr, "scenebench: unknown scene or dc '%s'\n", argv[a]);
+			return 1;
+		}
+	}
+
+	application.create();
+
+	scenes = new DCScenes(app);
+	scenes->create();
+
+	page.function = BLT_SRC;
+	page.lineStyle = LINE_SOLID;
+	page.capStyle = CAP_BUTT;
+	page.joinStyle = JOIN_MITER;
+	page.fillStyle = FILL_SOLID;
+	page.forecolor = FXRGB(255,0,0);
+	page.backcolor = FXRGB(0,0,255);
+	page.erasecolor = FXRGB(255,255,255);
+	page.stipple = STIPPLE_NONE;
+	page.lineWidth = 3;
+	page.textureImage = scenes->tile;
+	page.testFont = new FXFont(app,"helvetica",20,FXFont::Normal,FXFont::Straight,FONTENCODING_DEFAULT,FXFont::NonExpanded,FXFont::Scalable|FXFont::Rotatable);
+	page.testFontAngle = new FXFont(app,"helvetica",20,FXFont::Normal,FXFont::Straight,FONTENCODING_DEFAULT,FXFont::NonExpanded,FXFont::Scalable|FXFont::Rotatable);
+	page.testFontAngle->setAngle(90*64);
+	page.testFont->create();
+	page.testFontAngle->create();
+	page.ang1 = 0;
+	page.ang2 = 90;
+	page.cornerw = 10;
+	page.cornerh = 10;
+
+	target = new FXImage(app, NULL, 0, TARGET_W, TARGET_H);
+	target->create();
+	FXMALLOC(&pixels, FXuchar, FXDCCairoImage::getStride(TARGET_W)*TARGET_H);
+
+	for (FXuint s = 0; s <= SCENE_PAGE; ++s) {
+		if (anyScene && !wantScene[s])
+			continue;
+		for (FXuint k = 0; k < DC_LAST; ++k)
+			if (!anyDC || wantDC[k])
+				bench(s, k, reps);
+	}
+
+	FXFREE(&pixels);
+	delete target;
+	delete page.testFont;
+	delete page.testFontAngle;
+	delete scenes;
+	return 0;
+}